@@ -27,15 +27,27 @@ def is_msvc():
 # Source files for the extension
 sources = [
     'src/stockfish_nnue_bindings.cpp',
+    'src/actstats.cpp',
+    'src/analysis.cpp',
+    'src/batch.cpp',
     'src/benchmark.cpp',
     'src/bitboard.cpp',
+    'src/dispatcher.cpp',
+    'src/evalcache.cpp',
     'src/evaluate.cpp',
+    'src/extract.cpp',
     'src/memory.cpp',
     'src/misc.cpp',
+    'src/movebatch.cpp',
     'src/movegen.cpp',
+    'src/nnue_interface.cpp',
     'src/movepick.cpp',
+    'src/perft.cpp',
+    'src/pipeline.cpp',
+    'src/planes.cpp',
     'src/position.cpp',
     'src/search.cpp',
+    'src/server.cpp',
     'src/thread.cpp',
     'src/timeman.cpp',
     'src/tt.cpp',
@@ -43,6 +55,7 @@ sources = [
     'src/ucioption.cpp',
     'src/tune.cpp',
     'src/syzygy/tbprobe.cpp',
+    'src/tbbatch.cpp',
     'src/nnue/nnue_accumulator.cpp',
     'src/nnue/nnue_misc.cpp',
     'src/nnue/features/half_ka_v2_hm.cpp',
@@ -198,6 +211,7 @@ ext_modules = [
             'src/nnue',
         ],
         language='c++',
+        define_macros=[('NNUE_INTERFACE_STATIC', None)],  # The C API is linked in, not imported
         extra_compile_args=extra_compile_args,
         extra_link_args=extra_link_args,
     ),
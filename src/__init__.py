@@ -83,8 +83,42 @@ try:
     get_activations_and_eval = _nnue.get_activations_and_eval
     get_evaluation = _nnue.get_evaluation
     get_network_info = _nnue.get_network_info
+    set_eval_cache = _nnue.set_eval_cache
+    clear_eval_cache = _nnue.clear_eval_cache
+    get_eval_cache_stats = _nnue.get_eval_cache_stats
+    evaluate_batch = _nnue.evaluate_batch
+    evaluate_batch_into = _nnue.evaluate_batch_into
+    evaluate_trajectory = _nnue.evaluate_trajectory
+    get_stats = _nnue.get_stats
+    evaluate_async = _nnue.evaluate_async
+    activations_async = _nnue.activations_async
+    init_tablebases = _nnue.init_tablebases
+    probe_tablebases_batch = _nnue.probe_tablebases_batch
+    warm_tablebases = _nnue.warm_tablebases
+    get_tablebase_residency = _nnue.get_tablebase_residency
+    legal_moves_batch = _nnue.legal_moves_batch
+    perft = _nnue.perft
+    set_search_option = _nnue.set_search_option
+    save_hash = _nnue.save_hash
+    load_hash = _nnue.load_hash
+    analyze_games = _nnue.analyze_games
+    analyze_root_moves = _nnue.analyze_root_moves
+    SearchEngine = _nnue.SearchEngine
+    ActivationStats = _nnue.ActivationStats
+    Pipeline = _nnue.Pipeline
+    Coalescer = _nnue.Coalescer
+    Server = _nnue.Server
+    server_benchmark = _nnue.server_benchmark
     
-    __all__ = ['get_activations_and_eval', 'get_evaluation', 'get_network_info', '__version__']
+    __all__ = ['get_activations_and_eval', 'get_evaluation', 'get_network_info',
+               'set_eval_cache', 'clear_eval_cache', 'get_eval_cache_stats',
+               'evaluate_batch', 'evaluate_batch_into', 'evaluate_trajectory',
+               'get_stats', 'evaluate_async',
+               'activations_async', 'init_tablebases',
+               'probe_tablebases_batch', 'warm_tablebases', 'get_tablebase_residency',
+               'legal_moves_batch', 'perft', 'set_search_option', 'save_hash', 'load_hash',
+               'analyze_games', 'analyze_root_moves', 'SearchEngine', 'ActivationStats', 'Pipeline',
+               'Coalescer', 'Server', 'server_benchmark', '__version__']
 except ImportError as e:
     print(f"Warning: Failed to import stockfish_nnue C++ extension: {e}", file=sys.stderr)
     raise
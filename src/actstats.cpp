@@ -0,0 +1,241 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "actstats.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "batch.h"
+#include "position.h"
+
+namespace Stockfish::Batch {
+
+using Extract::Layer1Size;
+using Extract::Layer2Size;
+
+NeuronStats::NeuronStats(Extract::IndexType                  dimensions,
+                         int                                 histogramBins,
+                         float                               accRange,
+                         const std::vector<CovarianceBlock>& blocks) :
+    bins(std::max(1, histogramBins)),
+    accumulationRange(accRange > 0.0f ? accRange : 1.0f) {
+
+    offsets[TENSOR_ACCUMULATION] = 0;
+    offsets[TENSOR_TRANSFORMED]  = COLOR_NB * dimensions;
+    offsets[TENSOR_LAYER1]       = offsets[TENSOR_TRANSFORMED] + dimensions;
+    offsets[TENSOR_LAYER2]       = offsets[TENSOR_LAYER1] + Layer1Size;
+    offsets[TENSOR_NB]           = offsets[TENSOR_LAYER2] + Layer2Size;
+
+    const std::size_t n = offsets[TENSOR_NB];
+
+    mean.assign(n, 0.0);
+    m2.assign(n, 0.0);
+    min.assign(n, std::numeric_limits<float>::max());
+    max.assign(n, std::numeric_limits<float>::lowest());
+    nonzero.assign(n, 0);
+    histogram.assign(n * bins, 0);
+    values.resize(n);
+
+    // Blocks are clipped to the tensor, which is smaller for the small network
+    for (const auto& b : blocks)
+    {
+        const std::size_t end = std::min(b.begin + b.size, size(b.tensor));
+        const std::size_t sz  = end - std::min(b.begin, end);
+        if (sz)
+            covariances.push_back({{b.tensor, b.begin, sz}, std::vector<double>(sz, 0.0),
+                                   std::vector<double>(sz * sz, 0.0), std::vector<double>(sz)});
+    }
+}
+
+
+void NeuronStats::range(Tensor t, float& lo, float& hi) const {
+    // The accumulator holds the raw signed int16 sums, which the transform only
+    // clips afterwards, so its range is configurable. The other tensors are
+    // clipped ReLU outputs in [0, 127].
+    lo = t == TENSOR_ACCUMULATION ? -accumulationRange : 0.0f;
+    hi = t == TENSOR_ACCUMULATION ? accumulationRange : 128.0f;
+}
+
+
+void NeuronStats::add(const Extract::Activations& act) {
+
+    const Extract::IndexType dims = act.dimensions;
+    float*                   v    = values.data();
+
+    for (Color c : {WHITE, BLACK})
+        std::copy(act.accumulation[c], act.accumulation[c] + dims, v + c * dims);
+
+    std::copy(act.transformed, act.transformed + dims, v + offsets[TENSOR_TRANSFORMED]);
+    std::copy(act.layer1, act.layer1 + Layer1Size, v + offsets[TENSOR_LAYER1]);
+    std::copy(act.layer2, act.layer2 + Layer2Size, v + offsets[TENSOR_LAYER2]);
+
+    ++count;
+
+    for (int t = 0; t < TENSOR_NB; ++t)
+    {
+        float lo, hi;
+        range(Tensor(t), lo, hi);
+        const float scale = bins / (hi - lo);
+
+        for (std::size_t i = offsets[t]; i < offsets[t + 1]; ++i)
+        {
+            const double x     = v[i];
+            const double delta = x - mean[i];
+
+            mean[i] += delta / count;
+            m2[i] += delta * (x - mean[i]);
+            min[i] = std::min(min[i], v[i]);
+            max[i] = std::max(max[i], v[i]);
+            nonzero[i] += v[i] != 0.0f;
+
+            const int bin = std::clamp(int((v[i] - lo) * scale), 0, bins - 1);
+            histogram[i * bins + bin]++;
+        }
+    }
+
+    for (auto& cov : covariances)
+    {
+        const float*      x  = v + offsets[cov.block.tensor] + cov.block.begin;
+        const std::size_t sz = cov.block.size;
+
+        // Welford's update of the co-moment: C += (x - mean_old) (x - mean_new)^T
+        for (std::size_t i = 0; i < sz; ++i)
+        {
+            cov.delta[i] = x[i] - cov.mean[i];
+            cov.mean[i] += cov.delta[i] / count;
+        }
+
+        for (std::size_t i = 0; i < sz; ++i)
+            for (std::size_t j = 0; j < sz; ++j)
+                cov.comoment[i * sz + j] += cov.delta[i] * (x[j] - cov.mean[j]);
+    }
+}
+
+
+// Combines the moments of two disjoint streams (Chan et al.)
+void NeuronStats::merge(const NeuronStats& other) {
+
+    if (!other.count)
+        return;
+
+    const double na = double(count), nb = double(other.count), n = na + nb;
+
+    for (std::size_t i = 0; i < mean.size(); ++i)
+    {
+        const double delta = other.mean[i] - mean[i];
+
+        mean[i] += delta * nb / n;
+        m2[i] += other.m2[i] + delta * delta * na * nb / n;
+        min[i] = std::min(min[i], other.min[i]);
+        max[i] = std::max(max[i], other.max[i]);
+        nonzero[i] += other.nonzero[i];
+    }
+
+    for (std::size_t i = 0; i < histogram.size(); ++i)
+        histogram[i] += other.histogram[i];
+
+    for (std::size_t k = 0; k < covariances.size(); ++k)
+    {
+        auto&             a  = covariances[k];
+        const auto&       b  = other.covariances[k];
+        const std::size_t sz = a.block.size;
+
+        for (std::size_t i = 0; i < sz; ++i)
+            a.delta[i] = b.mean[i] - a.mean[i];
+
+        for (std::size_t i = 0; i < sz; ++i)
+            for (std::size_t j = 0; j < sz; ++j)
+                a.comoment[i * sz + j] +=
+                  b.comoment[i * sz + j] + a.delta[i] * a.delta[j] * na * nb / n;
+
+        for (std::size_t i = 0; i < sz; ++i)
+            a.mean[i] += a.delta[i] * nb / n;
+    }
+
+    count += other.count;
+}
+
+
+ActivationStats::ActivationStats(const Eval::NNUE::Networks&         nets,
+                                 EvalCache*                          cache,
+                                 std::size_t                         threads,
+                                 int                                 histogramBins,
+                                 float                               accRange,
+                                 const std::vector<CovarianceBlock>& covarianceBlocks) :
+    networks(nets),
+    evalCache(cache),
+    bins(std::max(1, histogramBins)),
+    accumulationRange(accRange),
+    blocks(covarianceBlocks),
+    workers(std::max<std::size_t>(1, threads)) {}
+
+
+NeuronStats ActivationStats::empty(bool smallNet) const {
+    return NeuronStats(smallNet ? Eval::NNUE::TransformedFeatureDimensionsSmall
+                                : Eval::NNUE::TransformedFeatureDimensionsBig,
+                       bins, accumulationRange, blocks);
+}
+
+
+void ActivationStats::update(const std::vector<std::string>& input) {
+
+    // Checked first, so that a bad row leaves the statistics untouched
+    const std::vector<std::string> fens = checked_fens(input);
+
+    parallel_for(workers.size(), fens.size(), [&](std::size_t t, std::size_t i) {
+        Worker& w = workers[t];
+
+        if (!w.extractor)
+        {
+            w.extractor   = std::make_unique<Extract::Extractor>(networks, evalCache);
+            w.activations = std::make_unique<Extract::Activations>();
+        }
+
+        StateInfo st;
+        Position  pos;
+        pos.set(fens[i], false, &st);
+
+        const bool smallNet = w.extractor->evaluate(pos, w.activations.get()).smallNet;
+
+        if (!w.stats[smallNet])
+            w.stats[smallNet] = std::make_unique<NeuronStats>(empty(smallNet));
+
+        w.stats[smallNet]->add(*w.activations);
+    });
+}
+
+
+void ActivationStats::reset() {
+    for (auto& w : workers)
+        w.stats[0].reset(), w.stats[1].reset();
+}
+
+
+NeuronStats ActivationStats::result(bool smallNet) const {
+
+    NeuronStats total = empty(smallNet);
+
+    for (const auto& w : workers)
+        if (w.stats[smallNet])
+            total.merge(*w.stats[smallNet]);
+
+    return total;
+}
+
+}  // namespace Stockfish::Batch
@@ -0,0 +1,137 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ACTSTATS_H_INCLUDED
+#define ACTSTATS_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "extract.h"
+
+namespace Stockfish {
+
+class EvalCache;
+
+namespace Batch {
+
+// The activation tensors statistics are collected for. Accumulation covers both
+// perspectives, white first.
+enum Tensor {
+    TENSOR_ACCUMULATION,
+    TENSOR_TRANSFORMED,
+    TENSOR_LAYER1,
+    TENSOR_LAYER2,
+    TENSOR_NB
+};
+
+// A square block [begin, begin + size) of neurons of one tensor whose covariance
+// matrix is accumulated
+struct CovarianceBlock {
+    Tensor      tensor;
+    std::size_t begin;
+    std::size_t size;
+};
+
+// Streaming per-neuron statistics of one network: mean and variance (Welford),
+// min/max, number of nonzero values, histograms and covariance blocks. Moments
+// of separate streams are combined with merge(), so nothing is ever stored per
+// position.
+class NeuronStats {
+   public:
+    NeuronStats(Extract::IndexType                  dimensions,
+                int                                 bins,
+                float                               accumulationRange,
+                const std::vector<CovarianceBlock>& blocks);
+
+    void add(const Extract::Activations& act);
+    void merge(const NeuronStats& other);
+
+    // Per-tensor views: neurons of tensor t are [offset(t), offset(t) + size(t))
+    std::size_t offset(Tensor t) const { return offsets[t]; }
+    std::size_t size(Tensor t) const { return offsets[t + 1] - offsets[t]; }
+
+    // Histogram range of tensor t; values outside it go to the first or last bin
+    void range(Tensor t, float& lo, float& hi) const;
+
+    std::uint64_t count = 0;
+    int           bins;
+    float         accumulationRange;  // Accumulator histogram covers [-range, range]
+
+    std::vector<double>        mean, m2;
+    std::vector<float>         min, max;
+    std::vector<std::uint64_t> nonzero;
+    std::vector<std::uint64_t> histogram;  // [neuron][bins]
+
+    struct Covariance {
+        CovarianceBlock     block;
+        std::vector<double> mean;
+        std::vector<double> comoment;  // [size][size], covariance is comoment / count
+        std::vector<double> delta;     // Scratch
+    };
+    std::vector<Covariance> covariances;
+
+   private:
+    std::size_t        offsets[TENSOR_NB + 1];
+    std::vector<float> values;  // Scratch row of the neurons of one position
+};
+
+// ActivationStats evaluates a stream of positions on a set of worker threads
+// and folds their activations into per-thread NeuronStats, one set per network,
+// which are merged when the result is requested.
+class ActivationStats {
+   public:
+    ActivationStats(const Eval::NNUE::Networks&         networks,
+                    EvalCache*                          cache,
+                    std::size_t                         threads,
+                    int                                 bins,
+                    float                               accumulationRange,
+                    const std::vector<CovarianceBlock>& blocks);
+
+    // Throws std::invalid_argument, adding nothing, if a FEN is not well formed
+    void update(const std::vector<std::string>& fens);
+    void reset();
+
+    // Statistics of all positions seen so far, for the big or the small network
+    NeuronStats result(bool smallNet) const;
+
+   private:
+    struct Worker {
+        std::unique_ptr<Extract::Extractor>   extractor;
+        std::unique_ptr<Extract::Activations> activations;
+        std::unique_ptr<NeuronStats>          stats[2];  // [big, small]
+    };
+
+    NeuronStats empty(bool smallNet) const;
+
+    const Eval::NNUE::Networks&  networks;
+    EvalCache*                   evalCache;
+    int                          bins;
+    float                        accumulationRange;
+    std::vector<CovarianceBlock> blocks;
+    std::vector<Worker>          workers;
+};
+
+}  // namespace Batch
+
+}  // namespace Stockfish
+
+#endif  // #ifndef ACTSTATS_H_INCLUDED
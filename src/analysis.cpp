@@ -0,0 +1,286 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "analysis.h"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <thread>
+
+#include "batch.h"
+#include "misc.h"
+#include "movegen.h"
+#include "position.h"
+#include "thread.h"
+#include "tt.h"
+#include "uci.h"
+#include "ucioption.h"
+
+namespace Stockfish::Batch {
+
+namespace {
+
+struct Task {
+    std::size_t game, ply;
+};
+
+// A ThreadPool of one thread, whose search callbacks are forwarded to the ones
+// of the search it runs
+struct Worker {
+    Worker(const OptionsMap&                                options,
+           TranspositionTable&                              table,
+           const LazyNumaReplicated<Eval::NNUE::Networks>& networks,
+           const NumaConfig&                                numaConfig) :
+        tt(table) {
+
+        updates.onUpdateNoMoves = [this](const Search::InfoShort& info) { onNoMoves(info); };
+        updates.onUpdateFull    = [this](const Search::InfoFull& info) { onFull(info); };
+        updates.onIter          = [](const Search::InfoIteration&) {};
+        updates.onBestmove      = [this](std::string_view bestmove, std::string_view) {
+            onBestmove(bestmove);
+        };
+
+        tt.attach();
+        threads.set(numaConfig, {options, threads, tt, networks}, updates, 1);
+        threads.ensure_network_replicated();
+    }
+
+    ~Worker() {
+        threads.main_thread()->wait_for_search_finished();
+        tt.detach();
+    }
+
+    TranspositionTable&                  tt;
+    Search::SearchManager::UpdateContext updates;  // Referenced by the pool's SearchManager
+    ThreadPool                           threads;
+
+    std::function<void(const Search::InfoShort&)> onNoMoves;
+    std::function<void(const Search::InfoFull&)>  onFull;
+    std::function<void(std::string_view)>         onBestmove;
+};
+
+// Runs `count` searches on `workers` Workers, each taking the next search as
+// soon as its own is done. `prepare(worker, i, pos)` sets up the position of
+// search i and the worker's callbacks, and returns the position's states;
+// `finish(i, pos)` is called once the search is done.
+template<typename Prepare, typename Finish>
+void search_all(std::size_t                                      count,
+                std::size_t                                      workers,
+                const Search::LimitsType&                        limits,
+                const OptionsMap&                                options,
+                TranspositionTable&                              tt,
+                const LazyNumaReplicated<Eval::NNUE::Networks>& networks,
+                const NumaConfig&                                numaConfig,
+                const Prepare&                                   prepare,
+                const Finish&                                    finish) {
+
+    workers = std::clamp<std::size_t>(workers, 1, std::max<std::size_t>(1, count));
+
+    std::vector<std::unique_ptr<Worker>> pool;
+    for (std::size_t i = 0; i < workers; ++i)
+        pool.push_back(std::make_unique<Worker>(options, tt, networks, numaConfig));
+
+    std::atomic<std::size_t> next{0};
+    std::vector<std::thread> drivers;
+
+    for (auto& worker : pool)
+        drivers.emplace_back([&, w = worker.get()] {
+            for (std::size_t i; (i = next++) < count;)
+            {
+                Position     pos;
+                StateListPtr states = prepare(*w, i, pos);
+
+                Search::LimitsType taskLimits = limits;
+                taskLimits.startTime          = now();
+
+                w->threads.start_thinking(options, pos, states, taskLimits);
+                w->threads.main_thread()->wait_for_search_finished();
+                finish(i, pos);
+            }
+        });
+
+    for (auto& driver : drivers)
+        driver.join();
+}
+
+// Sets up the position of a game after `plies` moves from its checked start FEN,
+// keeping the states of the earlier positions for repetition detection
+StateListPtr
+replay(const std::string& fen, const Game& game, std::size_t plies, bool chess960, Position& pos) {
+
+    StateListPtr states(new std::deque<StateInfo>(1));
+    pos.set(fen, chess960, &states->back());
+
+    for (std::size_t i = 0; i < plies; ++i)
+    {
+        states->emplace_back();
+        pos.do_move(UCIEngine::to_move(pos, game.moves[i]), states->back());
+    }
+
+    return states;
+}
+
+}
+
+
+std::vector<std::vector<PlyAnalysis>>
+analyze_games(const std::vector<Game>&                         games,
+              const Search::LimitsType&                        limits,
+              std::size_t                                      workers,
+              const OptionsMap&                                options,
+              TranspositionTable&                              tt,
+              const LazyNumaReplicated<Eval::NNUE::Networks>& networks,
+              const NumaConfig&                                numaConfig) {
+
+    const bool                            chess960 = options["UCI_Chess960"];
+    std::vector<std::vector<PlyAnalysis>> results(games.size());
+    std::vector<Task>                     tasks;
+    std::vector<std::string>              fens;
+
+    // Checked here, before a worker thread parses them. epd_to_fen() only knows
+    // standard castling, Chess960 FENs are taken as given.
+    for (const Game& game : games)
+        fens.push_back(game.fen);
+    if (!chess960)
+        fens = checked_fens(fens);
+
+    for (std::size_t g = 0; g < games.size(); ++g)
+    {
+        StateListPtr states(new std::deque<StateInfo>(1));
+        Position     pos;
+        pos.set(fens[g], chess960, &states->back());
+
+        std::size_t plies = 0;
+        for (; plies < games[g].moves.size(); ++plies)
+        {
+            const Move m = UCIEngine::to_move(pos, games[g].moves[plies]);
+            if (m == Move::none())
+                break;
+
+            states->emplace_back();
+            pos.do_move(m, states->back());
+        }
+
+        results[g].resize(plies + 1);
+
+        for (std::size_t ply = plies + 1; ply-- > 0;)
+            tasks.push_back({g, ply});
+    }
+
+    search_all(
+      tasks.size(), workers, limits, options, tt, networks, numaConfig,
+      [&](Worker& w, std::size_t i, Position& pos) {
+          const Task&  task   = tasks[i];
+          PlyAnalysis* result = &results[task.game][task.ply];
+
+          w.onNoMoves = [result](const Search::InfoShort& info) {
+              result->depth = info.depth;
+              result->score = info.score;
+          };
+
+          w.onFull = [result](const Search::InfoFull& info) {
+              if (info.multiPV != 1)
+                  return;
+
+              result->depth      = info.depth;
+              result->score      = info.score;
+              result->lowerbound = info.bound == "lowerbound";
+              result->upperbound = info.bound == "upperbound";
+              result->nodes      = info.nodes;
+
+              result->pv.clear();
+              for (auto move : split(info.pv, " "))
+                  if (!move.empty())
+                      result->pv.emplace_back(move);
+          };
+
+          w.onBestmove = [result](std::string_view bestmove) { result->bestmove = bestmove; };
+
+          return replay(fens[task.game], games[task.game], task.ply, chess960, pos);
+      },
+      [](std::size_t, const Position&) {});
+
+    return results;
+}
+
+
+std::vector<std::vector<RootMoveAnalysis>>
+analyze_root_moves(const std::vector<std::string>&                  input,
+                   const Search::LimitsType&                        limits,
+                   std::size_t                                      workers,
+                   const OptionsMap&                                options,
+                   TranspositionTable&                              tt,
+                   const LazyNumaReplicated<Eval::NNUE::Networks>& networks,
+                   const NumaConfig&                                numaConfig) {
+
+    const bool                                 chess960 = options["UCI_Chess960"];
+    const std::vector<std::string>             fens     = chess960 ? input : checked_fens(input);
+    std::vector<std::vector<RootMoveAnalysis>> results(fens.size());
+
+    // The search limits the MultiPV to the number of root moves
+    Search::LimitsType allMoves = limits;
+    allMoves.multiPV            = MAX_MOVES;
+
+    search_all(
+      fens.size(), workers, allMoves, options, tt, networks, numaConfig,
+      [&](Worker& w, std::size_t i, Position& pos) {
+          StateListPtr states(new std::deque<StateInfo>(1));
+          pos.set(fens[i], chess960, &states->back());
+
+          auto& lines = results[i];
+          lines.resize(MoveList<LEGAL>(pos).size());
+
+          // Each iteration reports every line again, ranked by its new score
+          w.onFull = [&lines](const Search::InfoFull& info) {
+              if (info.multiPV > lines.size())
+                  return;
+
+              RootMoveAnalysis& line = lines[info.multiPV - 1];
+
+              line.uci        = info.pv.substr(0, info.pv.find(' '));
+              line.depth      = info.depth;
+              line.score      = info.score;
+              line.lowerbound = info.bound == "lowerbound";
+              line.upperbound = info.bound == "upperbound";
+              line.nodes      = info.moveNodes;
+          };
+
+          w.onNoMoves  = [](const Search::InfoShort&) {};
+          w.onBestmove = [](std::string_view) {};
+
+          return states;
+      },
+      [&](std::size_t i, const Position& pos) {
+          auto& lines = results[i];
+
+          lines.erase(std::remove_if(lines.begin(), lines.end(),
+                                     [](const RootMoveAnalysis& line) { return line.uci.empty(); }),
+                      lines.end());
+
+          for (auto& line : lines)
+              line.move = UCIEngine::to_move(pos, line.uci);
+      });
+
+    return results;
+}
+
+}  // namespace Stockfish::Batch
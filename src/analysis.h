@@ -0,0 +1,104 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ANALYSIS_H_INCLUDED
+#define ANALYSIS_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "numa.h"
+#include "score.h"
+#include "search.h"
+#include "types.h"
+
+namespace Stockfish {
+
+class OptionsMap;
+class TranspositionTable;
+
+namespace Eval::NNUE {
+struct Networks;
+}
+
+namespace Batch {
+
+struct Game {
+    std::string              fen;
+    std::vector<std::string> moves;  // UCI notation
+};
+
+// Search result of one position of a game, as the last "info" line and the
+// "bestmove" of a UCI search would report it
+struct PlyAnalysis {
+    int                      depth = 0;  // 0 if the side to move has no legal move
+    Score                    score;      // From the side to move
+    bool                     lowerbound = false, upperbound = false;
+    std::uint64_t            nodes      = 0;
+    std::string              bestmove;  // "(none)" without a legal move
+    std::vector<std::string> pv;
+};
+
+// Searches every position of the games: the start position, then the one after
+// each move, stopping at the first illegal move of a game. The positions are
+// handed to `workers` single-threaded searches, each a ThreadPool of one thread,
+// so that short searches don't pay for Lazy SMP. They share the table and the
+// networks, and take the positions of each game from its last one backwards, so
+// that an earlier ply finds the entries of the plies that follow it. Results
+// are indexed by game, then ply. Throws std::invalid_argument, searching
+// nothing, if a start FEN is not well formed.
+std::vector<std::vector<PlyAnalysis>>
+analyze_games(const std::vector<Game>&                         games,
+              const Search::LimitsType&                        limits,
+              std::size_t                                      workers,
+              const OptionsMap&                                options,
+              TranspositionTable&                              tt,
+              const LazyNumaReplicated<Eval::NNUE::Networks>& networks,
+              const NumaConfig&                                numaConfig);
+
+// Search result of one root move, as its MultiPV "info" line reports it
+struct RootMoveAnalysis {
+    Move          move = Move::none();
+    std::string   uci;            // UCI notation of the move
+    int           depth = 0;      // Of the last iteration that searched the move
+    Score         score;          // From the side to move
+    bool          lowerbound = false, upperbound = false;
+    std::uint64_t nodes      = 0;  // Searched under the move
+};
+
+// Searches the positions with a MultiPV covering every legal move, on the
+// workers of analyze_games(). The moves of each position are listed best first,
+// in the order of the last iteration; moves the search didn't report before it
+// stopped are left out, as are those of positions without a legal move. FENs
+// are checked as in analyze_games().
+std::vector<std::vector<RootMoveAnalysis>>
+analyze_root_moves(const std::vector<std::string>&                  fens,
+                   const Search::LimitsType&                        limits,
+                   std::size_t                                      workers,
+                   const OptionsMap&                                options,
+                   TranspositionTable&                              tt,
+                   const LazyNumaReplicated<Eval::NNUE::Networks>& networks,
+                   const NumaConfig&                                numaConfig);
+
+}  // namespace Batch
+
+}  // namespace Stockfish
+
+#endif  // #ifndef ANALYSIS_H_INCLUDED
@@ -0,0 +1,595 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "batch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+#include "position.h"
+#include "uci.h"
+
+#if defined(USE_AVX2)
+    #include <immintrin.h>
+#endif
+
+namespace Stockfish::Batch {
+
+using Eval::NNUE::PSQTBuckets;
+using Extract::Layer1Size;
+using Extract::Layer2Size;
+using Extract::MaxDimensions;
+
+namespace {
+
+constexpr std::size_t PsqtRow  = COLOR_NB * PSQTBuckets;
+constexpr std::size_t PlaneRow = Planes::PLANE_NB * SQUARE_NB;
+
+template<typename T>
+void copy_to(T* data, std::size_t width, std::size_t from, std::size_t to) {
+    if (data)
+        std::memcpy(data + to * width, data + from * width, width * sizeof(T));
+}
+
+// Converts the first `size` neurons of src to float, zero padded to `full`, or
+// only the selected ones, which read as zero past `size`. Output bandwidth and
+// conversion cost thus scale with the selection.
+template<typename T>
+void export_neurons(const T* src, std::size_t size, std::size_t full, const Selection& sel, float* dst) {
+
+    if (!sel.index)
+    {
+        std::fill(std::copy(src, src + size, dst), dst + full, 0.0f);
+        return;
+    }
+
+    std::size_t i = 0;
+
+#if defined(USE_AVX2)
+    // Gathers eight 16-bit neurons at a time as 32-bit words whose upper half
+    // is shifted out. Lanes past `size` are masked off and never read; the last
+    // neuron's word spills into the next member of Activations.
+    if constexpr (sizeof(T) == 2)
+    {
+        const __m256i limit = _mm256_set1_epi32(int(size));
+        const int*    base  = reinterpret_cast<const int*>(src);
+
+        for (; i + 8 <= sel.size; i += 8)
+        {
+            const __m256i idx  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sel.index + i));
+            const __m256i mask = _mm256_cmpgt_epi32(limit, idx);
+            __m256i v = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), base, idx, mask, 2);
+            v         = _mm256_srai_epi32(_mm256_slli_epi32(v, 16), 16);
+            _mm256_storeu_ps(dst + i, _mm256_cvtepi32_ps(v));
+        }
+    }
+#endif
+
+    for (; i < sel.size; ++i)
+        dst[i] = sel.index[i] < size ? float(src[sel.index[i]]) : 0.0f;
+}
+
+}
+
+
+std::vector<std::string> checked_fens(const std::vector<std::string>& fens) {
+
+    std::vector<std::string> checked(fens.size());
+
+    for (std::size_t i = 0; i < fens.size(); ++i)
+        if ((checked[i] = epd_to_fen(fens[i])).empty())
+            throw std::invalid_argument("invalid position at index " + std::to_string(i) + ": "
+                                        + fens[i]);
+    return checked;
+}
+
+
+std::string checked_fen(const std::string& fen) {
+
+    std::string checked = epd_to_fen(fen);
+    if (checked.empty())
+        throw std::invalid_argument("invalid position: " + fen);
+    return checked;
+}
+
+
+WorkerPool::WorkerPool(std::size_t threads) { set_threads(threads); }
+
+
+WorkerPool::~WorkerPool() { stop(); }
+
+
+void WorkerPool::set_threads(std::size_t threads) {
+
+    threads = std::max<std::size_t>(1, threads);
+    if (threads == size())
+        return;
+
+    stop();
+    exiting = false;
+
+    for (std::size_t t = 1; t < threads; ++t)
+        workers.emplace_back(&WorkerPool::idle_loop, this, t);
+}
+
+
+void WorkerPool::stop() {
+    {
+        std::lock_guard<std::mutex> lk(mutex);
+        exiting = true;
+    }
+    wake.notify_all();
+
+    for (auto& th : workers)
+        th.join();
+    workers.clear();
+}
+
+
+void WorkerPool::run(std::size_t threads, const std::function<void(std::size_t)>& work) {
+
+    threads = std::max<std::size_t>(1, std::min(threads, size()));
+
+    if (threads > 1)
+    {
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            job     = &work;
+            active  = threads;
+            running = threads - 1;
+            ++calls;
+        }
+        wake.notify_all();
+    }
+
+    // The workers use `work` until they are done, also if part 0 throws
+    std::exception_ptr error;
+    try
+    {
+        work(0);
+    } catch (...)
+    {
+        error = std::current_exception();
+    }
+
+    if (threads > 1)
+    {
+        std::unique_lock<std::mutex> lk(mutex);
+        done.wait(lk, [&] { return running == 0; });
+        job = nullptr;
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+
+void WorkerPool::idle_loop(std::size_t threadIdx) {
+
+    std::uint64_t seen = 0;
+
+    while (true)
+    {
+        std::unique_lock<std::mutex> lk(mutex);
+        wake.wait(lk, [&] { return exiting || calls != seen; });
+
+        if (exiting)
+            return;
+
+        seen = calls;
+        if (threadIdx >= active)
+            continue;
+
+        const auto& work = *job;
+        lk.unlock();
+
+        work(threadIdx);
+
+        lk.lock();
+        if (--running == 0)
+            done.notify_one();
+    }
+}
+
+
+Evaluator::Evaluator(const Eval::NNUE::Networks& nets, EvalCache* cache, std::size_t threads) :
+    networks(nets),
+    evalCache(cache),
+    pool(threads),
+    prober(threads) {
+    set_threads(threads);
+}
+
+
+void Evaluator::set_threads(std::size_t threads) {
+    numThreads = std::max<std::size_t>(1, threads);
+    pool.set_threads(numThreads);
+    extractors.resize(numThreads);
+    prober.set_threads(numThreads);
+}
+
+
+// Extractors are created lazily by the thread that first uses them, so their
+// memory is first touched (and on NUMA systems placed) by that thread.
+Extract::Extractor& Evaluator::extractor(std::size_t threadIdx) {
+    auto& ex = extractors[threadIdx];
+    if (!ex)
+        ex = std::make_unique<Extract::Extractor>(networks, evalCache);
+    return *ex;
+}
+
+
+Stats Evaluator::evaluate(const std::vector<std::string>& input,
+                          const Outputs&                  out,
+                          bool                            dedup,
+                          bool                            tablebases) {
+
+    const std::vector<std::string> fens = checked_fens(input);
+    const std::size_t              n    = fens.size();
+    Stats                          stats;
+    stats.positions = n;
+
+    // leader[i] is the row whose result row i receives; unique rows lead themselves
+    std::vector<std::size_t> leader(n);
+    std::iota(leader.begin(), leader.end(), 0);
+
+    if (dedup && n > 1)
+    {
+        std::vector<std::pair<Key, std::size_t>> keys(n);
+
+        parallel_for(pool, n, [&](std::size_t, std::size_t i) {
+            StateInfo st;
+            Position  pos;
+            pos.set(fens[i], false, &st);
+            keys[i] = {Extract::cache_key(pos), i};
+        });
+
+        // Sorting keeps the lowest row of each run of equal keys first
+        std::sort(keys.begin(), keys.end());
+
+        for (std::size_t j = 1; j < n; ++j)
+            if (keys[j].first == keys[j - 1].first)
+                leader[keys[j].second] = leader[keys[j - 1].second];
+    }
+
+    std::vector<std::size_t> unique;
+    for (std::size_t i = 0; i < n; ++i)
+        if (leader[i] == i)
+            unique.push_back(i);
+
+    const std::size_t rows = out.mirror ? 2 * n : n;
+
+    sparseOffsets.clear();
+    if (out.sparseTransformed)
+    {
+        sparseBuffers.resize(numThreads);
+        for (auto& b : sparseBuffers)
+            b.index.clear(), b.value.clear();
+        sparseRows.assign(rows, SparseRow());
+    }
+
+    std::vector<std::unique_ptr<Extract::Activations>> scratch(numThreads);
+    const bool                                         wantsActivations = out.wants_activations();
+    const bool                                         wantsPlanes      = out.wants_planes();
+    std::atomic<std::size_t>                           tbCount{0};
+
+    parallel_for(pool, unique.size(), [&](std::size_t t, std::size_t j) {
+        StateInfo st;
+        Position  pos;
+        pos.set(fens[unique[j]], false, &st);
+
+        if (wantsPlanes)
+            store_planes(out, unique[j], pos);
+
+        TBResult tb;
+        if (tablebases && prober.probe(t, pos, false, tb) && tb.wdlState != Tablebases::FAIL)
+        {
+            store_tablebase(out, unique[j], Tablebases::WDLScore(tb.wdl));
+            tbCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        if (wantsActivations && !scratch[t])
+            scratch[t] = std::make_unique<Extract::Activations>();
+
+        Extract::Activations* act   = scratch[t].get();
+        const Extract::Score  score = extractor(t).evaluate(pos, act);
+        store(out, unique[j], score, act);
+
+        if (out.sparseTransformed)
+            store_sparse(t, unique[j], *act);
+    });
+
+    stats.tablebase = tbCount;
+    stats.evaluated = unique.size() - stats.tablebase;
+    stats.saved     = n - unique.size();
+
+    if (stats.saved)
+        parallel_for(pool, n, [&](std::size_t, std::size_t i) {
+            if (leader[i] != i)
+                copy_row(out, leader[i], i);
+        });
+
+    if (out.mirror)
+        parallel_for(pool, n, [&](std::size_t, std::size_t i) { mirror_row(out, i, n + i); });
+
+    // Transformed features are from the side to move's point of view, so twins
+    // share them with their original, like duplicates share their leader's.
+    if (out.sparseTransformed)
+    {
+        sparseOffsets.assign(rows + 1, 0);
+
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            sparseRows[i]        = sparseRows[leader[i % n]];
+            sparseOffsets[i + 1] = sparseOffsets[i] + sparseRows[i].count;
+        }
+    }
+
+    return stats;
+}
+
+
+std::size_t Evaluator::evaluate_trajectory(const std::string&              input,
+                                           const std::vector<std::string>& moves,
+                                           const Outputs&                  out,
+                                           bool                            chess960) {
+
+    // epd_to_fen() only knows standard castling, Chess960 FENs are taken as given
+    const std::string fen = chess960 ? input : checked_fen(input);
+
+    // The moves are checked once, then every thread replays them up to its stretch
+    std::vector<Move> line;
+    {
+        std::vector<StateInfo> states(moves.size() + 1);
+        Position               pos;
+        pos.set(fen, chess960, &states[0]);
+
+        for (const auto& uci : moves)
+        {
+            const Move m = UCIEngine::to_move(pos, uci);
+            if (m == Move::none())
+                break;
+
+            line.push_back(m);
+            pos.do_move(m, states[line.size()]);
+        }
+    }
+
+    const std::size_t rows             = line.size() + 1;
+    const std::size_t segments         = std::min(numThreads, rows);
+    const bool        wantsActivations = out.wants_activations();
+
+    parallel_for<1>(pool, segments, [&](std::size_t t, std::size_t s) {
+        const std::size_t begin = s * rows / segments;
+        const std::size_t end   = (s + 1) * rows / segments;
+
+        std::vector<StateInfo> states(end);
+        Position               pos;
+        pos.set(fen, chess960, &states[0]);
+
+        std::unique_ptr<Extract::Activations> act;
+        if (wantsActivations)
+            act = std::make_unique<Extract::Activations>();
+
+        for (std::size_t i = 0; i < end; ++i)
+        {
+            if (i >= begin)
+            {
+                if (out.wants_planes())
+                    store_planes(out, i, pos);
+
+                store(out, i, extractor(t).evaluate(pos, act.get()), act.get());
+            }
+
+            if (i + 1 < end)
+                pos.do_move(line[i], states[i + 1]);
+        }
+    });
+
+    return rows;
+}
+
+
+void Evaluator::store(const Outputs&              out,
+                      std::size_t                 row,
+                      const Extract::Score&       score,
+                      const Extract::Activations* act) {
+
+    if (out.final)
+        out.final[row] = float(score.final) / 100.0f;
+    if (out.psqt)
+        out.psqt[row] = float(score.psqt) / 100.0f;
+    if (out.positional)
+        out.positional[row] = float(score.positional) / 100.0f;
+    if (out.smallNet)
+        out.smallNet[row] = score.smallNet;
+    if (out.source)
+        out.source[row] = SOURCE_NNUE;
+
+    if (!act)
+        return;
+
+    if (out.accumulation)
+    {
+        const std::size_t width = out.accumulation_width();
+
+        for (Color c : {WHITE, BLACK})
+            export_neurons(act->accumulation[c], act->dimensions, MaxDimensions,
+                           out.accumulationSelection, out.accumulation + (row * COLOR_NB + c) * width);
+    }
+
+    if (out.psqtAccumulation)
+        std::copy(&act->psqtAccumulation[0][0], &act->psqtAccumulation[0][0] + PsqtRow,
+                  out.psqtAccumulation + row * PsqtRow);
+
+    if (out.layer1)
+        export_neurons(act->layer1, Layer1Size, Layer1Size, out.layer1Selection,
+                       out.layer1 + row * out.layer1_width());
+
+    if (out.layer2)
+        export_neurons(act->layer2, Layer2Size, Layer2Size, out.layer2Selection,
+                       out.layer2 + row * out.layer2_width());
+
+    if (out.transformedMask)
+        Extract::nonzero_mask(act->transformed, act->dimensions, out.transformedMask + row * MaskWords);
+
+    if (out.layerMask)
+    {
+        Extract::nonzero_mask(act->layer1, Layer1Size, out.layerMask + row * 2);
+        Extract::nonzero_mask(act->layer2, Layer2Size, out.layerMask + row * 2 + 1);
+    }
+}
+
+
+// Search scores a root position found in the tablebases with the 50-move rule
+// in effect: wins and losses just inside the TB range, cursed wins and blessed
+// losses as a near draw.
+Value Evaluator::tablebase_value(Tablebases::WDLScore wdl) {
+    return wdl < Tablebases::WDLBlessedLoss ? -VALUE_TB
+         : wdl > Tablebases::WDLCursedWin   ? VALUE_TB
+                                            : Value(2 * wdl);
+}
+
+
+void Evaluator::store_tablebase(const Outputs& out, std::size_t row, Tablebases::WDLScore wdl) const {
+
+    if (out.final)
+        out.final[row] = float(tablebase_value(wdl)) / 100.0f;
+    if (out.psqt)
+        out.psqt[row] = 0.0f;
+    if (out.positional)
+        out.positional[row] = 0.0f;
+    if (out.smallNet)
+        out.smallNet[row] = false;
+    if (out.source)
+        out.source[row] = SOURCE_TABLEBASE;
+
+    if (out.accumulation)
+        std::fill_n(out.accumulation + row * COLOR_NB * out.accumulation_width(),
+                    COLOR_NB * out.accumulation_width(), 0.0f);
+    if (out.psqtAccumulation)
+        std::fill_n(out.psqtAccumulation + row * PsqtRow, PsqtRow, 0.0f);
+    if (out.layer1)
+        std::fill_n(out.layer1 + row * out.layer1_width(), out.layer1_width(), 0.0f);
+    if (out.layer2)
+        std::fill_n(out.layer2 + row * out.layer2_width(), out.layer2_width(), 0.0f);
+    if (out.transformedMask)
+        std::fill_n(out.transformedMask + row * MaskWords, MaskWords, 0);
+    if (out.layerMask)
+        std::fill_n(out.layerMask + row * 2, 2, 0);
+}
+
+
+void Evaluator::store_planes(const Outputs& out, std::size_t row, const Position& pos) {
+
+    Bitboard planes[Planes::PLANE_NB];
+    Planes::encode(pos, planes);
+
+    if (out.packedPlanes)
+        std::copy(planes, planes + Planes::PLANE_NB, out.packedPlanes + row * Planes::PLANE_NB);
+
+    if (out.planes)
+        Planes::unpack(planes, out.planes + row * PlaneRow);
+}
+
+
+void Evaluator::copy_row(const Outputs& out, std::size_t from, std::size_t to) const {
+    copy_to(out.final, 1, from, to);
+    copy_to(out.psqt, 1, from, to);
+    copy_to(out.positional, 1, from, to);
+    copy_to(out.smallNet, 1, from, to);
+    copy_to(out.source, 1, from, to);
+    copy_to(out.accumulation, COLOR_NB * out.accumulation_width(), from, to);
+    copy_to(out.psqtAccumulation, PsqtRow, from, to);
+    copy_to(out.layer1, out.layer1_width(), from, to);
+    copy_to(out.layer2, out.layer2_width(), from, to);
+    copy_to(out.transformedMask, MaskWords, from, to);
+    copy_to(out.layerMask, 2, from, to);
+    copy_to(out.planes, PlaneRow, from, to);
+    copy_to(out.packedPlanes, Planes::PLANE_NB, from, to);
+}
+
+
+void Evaluator::mirror_row(const Outputs& out, std::size_t from, std::size_t to) const {
+
+    copy_row(out, from, to);
+
+    if (out.accumulation)
+    {
+        const std::size_t width = out.accumulation_width();
+        float*            acc   = out.accumulation + to * COLOR_NB * width;
+        std::swap_ranges(acc, acc + width, acc + width);
+    }
+
+    if (out.psqtAccumulation)
+        std::swap_ranges(out.psqtAccumulation + to * PsqtRow,
+                         out.psqtAccumulation + to * PsqtRow + PSQTBuckets,
+                         out.psqtAccumulation + to * PsqtRow + PSQTBuckets);
+
+    if (out.planes)
+        Planes::flip(out.planes + to * PlaneRow);
+
+    if (out.packedPlanes)
+        Planes::flip(out.packedPlanes + to * Planes::PLANE_NB);
+}
+
+
+void Evaluator::store_sparse(std::size_t threadIdx, std::size_t row, const Extract::Activations& act) {
+
+    SparseBuffer&     b     = sparseBuffers[threadIdx];
+    const std::size_t start = b.index.size();
+
+    b.index.resize(start + act.dimensions);
+    b.value.resize(start + act.dimensions);
+
+    const auto count = Extract::sparse_transformed(act, &b.index[start], &b.value[start]);
+
+    b.index.resize(start + count);
+    b.value.resize(start + count);
+    sparseRows[row] = {std::uint32_t(threadIdx), std::uint32_t(count), start};
+}
+
+
+void Evaluator::write_sparse(const SparseOutputs& out) const {
+
+    if (sparseOffsets.empty())
+        return;
+
+    const std::size_t rows = sparseOffsets.size() - 1;
+
+    if (out.offsets)
+        std::copy(sparseOffsets.begin(), sparseOffsets.end(), out.offsets);
+
+    parallel_for(pool, rows, [&](std::size_t, std::size_t i) {
+        const SparseRow&    r = sparseRows[i];
+        const SparseBuffer& b = sparseBuffers[r.thread];
+
+        if (out.index)
+            std::copy_n(b.index.data() + r.start, r.count, out.index + sparseOffsets[i]);
+        if (out.value)
+            std::copy_n(b.value.data() + r.start, r.count, out.value + sparseOffsets[i]);
+    });
+}
+
+}  // namespace Stockfish::Batch
@@ -0,0 +1,290 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BATCH_H_INCLUDED
+#define BATCH_H_INCLUDED
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "extract.h"
+#include "planes.h"
+#include "tbbatch.h"
+
+namespace Stockfish {
+
+class EvalCache;
+class Position;
+
+namespace Batch {
+
+// Threads kept parked on a condition variable between calls, so that a batch
+// doesn't pay for creating and joining threads. Worker i always runs the part
+// threadIdx = i of a call, and the calling thread runs part 0.
+class WorkerPool {
+   public:
+    explicit WorkerPool(std::size_t threads);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&)            = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void        set_threads(std::size_t threads);
+    std::size_t size() const { return workers.size() + 1; }
+
+    // Runs work(threadIdx) for every threadIdx in [0, threads), threads being at
+    // most size(), and returns once all of them are done
+    void run(std::size_t threads, const std::function<void(std::size_t)>& work);
+
+   private:
+    void idle_loop(std::size_t threadIdx);
+    void stop();
+
+    std::vector<std::thread>                workers;
+    std::mutex                              mutex;
+    std::condition_variable                 wake, done;
+    const std::function<void(std::size_t)>* job     = nullptr;
+    std::size_t                             active  = 0;  // Parts of the current call
+    std::size_t                             running = 0;  // Of those, still running on workers
+    std::uint64_t                           calls   = 0;
+    bool                                    exiting = false;
+};
+
+namespace Detail {
+
+template<std::size_t Chunk, typename Job>
+void run_chunks(std::atomic<std::size_t>& next, std::size_t count, std::size_t threadIdx, const Job& job) {
+    for (std::size_t begin; (begin = next.fetch_add(Chunk)) < count;)
+        for (std::size_t i = begin; i < std::min(begin + Chunk, count); ++i)
+            job(threadIdx, i);
+}
+
+}
+
+// Runs job(threadIdx, i) for every i in [0, count) on up to `threads` threads.
+// Items are handed out in small chunks, so threads that get cheap positions
+// pick up more of the work. threadIdx is stable for the duration of the call
+// and can be used to index per-thread state. Jobs that are expensive on their
+// own should use a Chunk of 1.
+template<std::size_t Chunk = 16, typename Job>
+void parallel_for(std::size_t threads, std::size_t count, const Job& job) {
+
+    threads = std::max<std::size_t>(1, std::min(threads, (count + Chunk - 1) / Chunk));
+
+    std::atomic<std::size_t> next{0};
+
+    std::vector<std::thread> pool;
+    for (std::size_t t = 1; t < threads; ++t)
+        pool.emplace_back([&, t] { Detail::run_chunks<Chunk>(next, count, t, job); });
+
+    Detail::run_chunks<Chunk>(next, count, 0, job);
+
+    for (auto& th : pool)
+        th.join();
+}
+
+// The same on the threads of a WorkerPool, where threadIdx is also stable
+// across calls
+template<std::size_t Chunk = 16, typename Job>
+void parallel_for(WorkerPool& pool, std::size_t count, const Job& job) {
+
+    const std::size_t threads = std::max<std::size_t>(1, std::min(pool.size(), (count + Chunk - 1) / Chunk));
+
+    std::atomic<std::size_t> next{0};
+
+    pool.run(threads, [&](std::size_t threadIdx) { Detail::run_chunks<Chunk>(next, count, threadIdx, job); });
+}
+
+// The FENs (or EPD lines) in the form Position::set() expects, see epd_to_fen().
+// Throws std::invalid_argument naming the first one that is not well formed, so
+// that a bad row rejects its batch before any thread parses it.
+std::vector<std::string> checked_fens(const std::vector<std::string>& fens);
+std::string              checked_fen(const std::string& fen);
+
+// Where the score of a row comes from
+enum Source : std::uint8_t {
+    SOURCE_NNUE,
+    SOURCE_TABLEBASE
+};
+
+// A subset of the neurons of one activation tensor, exported in the given order.
+// The default, empty selection exports the whole tensor.
+struct Selection {
+    const std::uint32_t* index = nullptr;
+    std::size_t          size  = 0;
+
+    std::size_t width(std::size_t full) const { return index ? size : full; }
+};
+
+// Words of a transformed feature nonzero mask
+constexpr std::size_t MaskWords = Extract::MaxDimensions / 64;
+
+// Destination buffers of a batch evaluation, one row per input position. Null
+// pointers are skipped. Scores use the bindings' scale (Value / 100), and the
+// per-network activation rows are MaxDimensions wide, zero padded for rows
+// that were evaluated by the small network. Rows scored by the tablebases
+// have zero psqt, positional and activations. Board planes are encoded from the
+// same parsed position, either one byte per square or one bitboard per plane.
+// With a selection, the rows of a tensor only hold the selected neurons, for
+// the accumulator the same ones of both perspectives. Sparse transformed
+// features are kept by the Evaluator, as their size is only known afterwards.
+// Nonzero masks have bit i % 64 of word i / 64 set when neuron i fired.
+//
+// With mirror set, the buffers hold 2n rows, and row n + i receives the colour-
+// flipped twin of row i. HalfKAv2_hm features are symmetric under a colour flip,
+// so the twin's accumulator is the original one with the perspectives swapped,
+// and everything computed from the side to move's point of view is unchanged.
+// Twins therefore cost a copy, not an evaluation.
+struct Outputs {
+    float*         final             = nullptr;  // [n]
+    float*         psqt              = nullptr;  // [n]
+    float*         positional        = nullptr;  // [n]
+    std::uint8_t*  smallNet          = nullptr;  // [n]
+    std::uint8_t*  source            = nullptr;  // [n] Source
+    float*         accumulation      = nullptr;  // [n][COLOR_NB][MaxDimensions or selected]
+    float*         psqtAccumulation  = nullptr;  // [n][COLOR_NB][PSQTBuckets]
+    float*         layer1            = nullptr;  // [n][Layer1Size or selected]
+    float*         layer2            = nullptr;  // [n][Layer2Size or selected]
+    std::uint64_t* transformedMask   = nullptr;  // [n][MaskWords]
+    std::uint64_t* layerMask         = nullptr;  // [n][2] layer1, layer2
+    std::uint8_t*  planes            = nullptr;  // [n][Planes::PLANE_NB][SQUARE_NB]
+    Bitboard*      packedPlanes      = nullptr;  // [n][Planes::PLANE_NB]
+    bool           mirror            = false;
+    bool           sparseTransformed = false;
+
+    Selection accumulationSelection, layer1Selection, layer2Selection;
+
+    bool wants_activations() const {
+        return accumulation || psqtAccumulation || layer1 || layer2 || sparseTransformed
+            || transformedMask || layerMask;
+    }
+    bool wants_planes() const { return planes || packedPlanes; }
+
+    // Row widths; the accumulator one is per perspective
+    std::size_t accumulation_width() const { return accumulationSelection.width(Extract::MaxDimensions); }
+    std::size_t layer1_width() const { return layer1Selection.width(Extract::Layer1Size); }
+    std::size_t layer2_width() const { return layer2Selection.width(Extract::Layer2Size); }
+};
+
+// Destination of the sparse transformed features in CSR form: the nonzero
+// features of row i are entries [offsets[i], offsets[i + 1]).
+struct SparseOutputs {
+    std::int64_t*  offsets = nullptr;  // [rows + 1]
+    std::uint16_t* index   = nullptr;  // [total] feature index
+    std::uint8_t*  value   = nullptr;  // [total] feature value, never zero
+};
+
+struct Stats {
+    std::size_t positions = 0;
+    std::size_t evaluated = 0;  // Unique positions that went through an Extractor
+    std::size_t tablebase = 0;  // Unique positions scored by the tablebases instead
+    std::size_t saved     = 0;  // Rows filled by copying the result of a duplicate
+};
+
+// Evaluates many independent positions on a pool of worker threads, kept
+// between batches, each with its own Extractor. Positions in a batch are first hashed, and each unique
+// position is evaluated once, with its results broadcast to all duplicate rows.
+// With tablebase rescoring, positions the loaded Syzygy tables cover take the
+// tablebase value instead of going through the networks.
+class Evaluator {
+   public:
+    Evaluator(const Eval::NNUE::Networks& networks, EvalCache* cache, std::size_t threads);
+
+    void        set_threads(std::size_t threads);
+    std::size_t threads() const { return numThreads; }
+
+    // Must be called whenever the tablebases are reloaded
+    void clear_tablebase_cache() { prober.clear(); }
+
+    // Throws std::invalid_argument, evaluating nothing, if a FEN is not well formed
+    Stats evaluate(const std::vector<std::string>& fens,
+                   const Outputs&                  out,
+                   bool                            dedup      = true,
+                   bool                            tablebases = false);
+
+    // Evaluates the positions of a game: the one given by fen, then the one after
+    // each move (in UCI notation), into rows 0..moves.size(). Stops at the first
+    // illegal move and returns the number of rows written. Rows are split into a
+    // contiguous stretch per thread, so that each Extractor walks neighbouring
+    // positions and its refresh caches only apply a few feature changes each.
+    // Outputs are as for evaluate(), without mirror or sparse features. A start
+    // FEN that is not well formed throws as in evaluate().
+    std::size_t evaluate_trajectory(const std::string&              fen,
+                                    const std::vector<std::string>& moves,
+                                    const Outputs&                  out,
+                                    bool                            chess960 = false);
+
+    // Nonzero transformed features of the last evaluate() call made with
+    // Outputs::sparseTransformed, for all of its rows including duplicates and twins
+    std::size_t sparse_total() const { return sparseOffsets.empty() ? 0 : std::size_t(sparseOffsets.back()); }
+    void        write_sparse(const SparseOutputs& out) const;
+
+    // Score of a WDL result, as the search scores tablebase hits at the root
+    static Value tablebase_value(Tablebases::WDLScore wdl);
+
+    // Fill in row `row` of the outputs, except for the sparse features
+    static void store(const Outputs&              out,
+                      std::size_t                 row,
+                      const Extract::Score&       score,
+                      const Extract::Activations* act);
+    static void store_planes(const Outputs& out, std::size_t row, const Position& pos);
+
+   private:
+    Extract::Extractor& extractor(std::size_t threadIdx);
+
+    void store_tablebase(const Outputs& out, std::size_t row, Tablebases::WDLScore wdl) const;
+    void copy_row(const Outputs& out, std::size_t from, std::size_t to) const;
+    void mirror_row(const Outputs& out, std::size_t from, std::size_t to) const;
+    void store_sparse(std::size_t threadIdx, std::size_t row, const Extract::Activations& act);
+
+    struct SparseBuffer {
+        std::vector<std::uint16_t> index;
+        std::vector<std::uint8_t>  value;
+    };
+
+    struct SparseRow {
+        std::uint32_t thread = 0;
+        std::uint32_t count  = 0;
+        std::size_t   start  = 0;
+    };
+
+    const Eval::NNUE::Networks&                      networks;
+    EvalCache*                                       evalCache;
+    std::size_t                                      numThreads;
+    mutable WorkerPool                               pool;  // Also used by write_sparse()
+    std::vector<std::unique_ptr<Extract::Extractor>> extractors;
+    Prober                                           prober;
+    std::vector<SparseBuffer>                        sparseBuffers;
+    std::vector<SparseRow>                           sparseRows;
+    std::vector<std::int64_t>                        sparseOffsets;
+};
+
+}  // namespace Batch
+
+}  // namespace Stockfish
+
+#endif  // #ifndef BATCH_H_INCLUDED
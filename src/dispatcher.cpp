@@ -0,0 +1,237 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "dispatcher.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include "bitboard.h"
+
+namespace Stockfish::Batch {
+
+using Eval::NNUE::PSQTBuckets;
+using Extract::Layer1Size;
+using Extract::Layer2Size;
+using Extract::MaxDimensions;
+
+void Histogram::add(std::uint64_t value) {
+
+    int i = int(value);
+    if (value >= 16)
+    {
+        const int e = int(msb(value));
+        i           = 16 + (e - 4) * SubBuckets + int((value >> (e - 3)) & (SubBuckets - 1));
+    }
+
+    ++counts[i];
+    ++total;
+    sum += value;
+    maximum = std::max(maximum, value);
+}
+
+
+void Histogram::merge(const Histogram& other) {
+    for (int i = 0; i < Size; ++i)
+        counts[i] += other.counts[i];
+    total += other.total;
+    sum += other.sum;
+    maximum = std::max(maximum, other.maximum);
+}
+
+
+std::uint64_t Histogram::lower_bound(int i) {
+
+    if (i < 16)
+        return std::uint64_t(i);
+
+    if (i >= Size)
+        return std::numeric_limits<std::uint64_t>::max();
+
+    const int e   = 4 + (i - 16) / SubBuckets;
+    const int sub = (i - 16) % SubBuckets;
+    return std::uint64_t(SubBuckets + sub) << (e - 3);
+}
+
+
+std::uint64_t Histogram::quantile(double q) const {
+
+    if (!total)
+        return 0;
+
+    const auto target = std::max<std::uint64_t>(1, std::uint64_t(std::ceil(q * total)));
+
+    std::uint64_t seen = 0;
+    for (int i = 0; i < Size; ++i)
+        if ((seen += counts[i]) >= target)
+            return std::min(lower_bound(i + 1) - 1, maximum);
+
+    return maximum;
+}
+
+
+Dispatcher::Dispatcher(const Eval::NNUE::Networks& networks,
+                       EvalCache*                  cache,
+                       std::size_t                 threads,
+                       std::size_t                 batchSize,
+                       std::uint64_t               maxDelayUs) :
+    evaluator(networks, cache, threads),
+    maxBatch(std::max<std::size_t>(1, batchSize)),
+    maxDelay(std::chrono::microseconds(maxDelayUs)) {
+    thread = std::thread(&Dispatcher::idle_loop, this);
+}
+
+
+Dispatcher::~Dispatcher() { stop(); }
+
+
+void Dispatcher::submit(std::vector<std::string> fens, bool activations, Callback done) {
+
+    // Checked here, as a bad position would fail the whole batch it lands in
+    fens = checked_fens(fens);
+    {
+        std::lock_guard<std::mutex> lk(mutex);
+        pendingPositions += fens.size();
+        pending.push_back({std::move(fens), activations, std::move(done), Clock::now()});
+    }
+    cv.notify_one();
+}
+
+
+void Dispatcher::stop() {
+    {
+        std::lock_guard<std::mutex> lk(mutex);
+        stopping = true;
+    }
+    cv.notify_one();
+
+    if (thread.joinable())
+        thread.join();
+}
+
+
+void Dispatcher::idle_loop() {
+
+    std::vector<Request> requests;
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lk(mutex);
+            cv.wait(lk, [&] { return stopping || !pending.empty(); });
+
+            if (pending.empty())
+                return;
+
+            // Hold a partial batch until the oldest request reaches its deadline
+            if (maxDelay.count() > 0)
+                cv.wait_until(lk, pending.front().submitted + maxDelay,
+                              [&] { return stopping || pendingPositions >= maxBatch; });
+
+            // Take whole requests up to maxBatch positions, and at least one
+            std::size_t positions = 0;
+            while (!pending.empty()
+                   && (requests.empty() || positions + pending.front().fens.size() <= maxBatch))
+            {
+                positions += pending.front().fens.size();
+                requests.push_back(std::move(pending.front()));
+                pending.pop_front();
+            }
+            pendingPositions -= positions;
+        }
+
+        dispatch(requests);
+        requests.clear();
+    }
+}
+
+
+void Dispatcher::dispatch(std::vector<Request>& requests) {
+
+    std::vector<std::string> fens;
+    bool                     activations = false;
+
+    for (auto& r : requests)
+    {
+        fens.insert(fens.end(), std::make_move_iterator(r.fens.begin()),
+                    std::make_move_iterator(r.fens.end()));
+        activations |= r.activations;
+    }
+
+    const std::size_t n = fens.size();
+
+    final.resize(n);
+    psqt.resize(n);
+    positional.resize(n);
+    smallNet.resize(n);
+
+    Outputs out;
+    out.final      = final.data();
+    out.psqt       = psqt.data();
+    out.positional = positional.data();
+    out.smallNet   = smallNet.data();
+
+    if (activations)
+    {
+        accumulation.resize(n * COLOR_NB * MaxDimensions);
+        psqtAccumulation.resize(n * COLOR_NB * PSQTBuckets);
+        layer1.resize(n * Layer1Size);
+        layer2.resize(n * Layer2Size);
+
+        out.accumulation     = accumulation.data();
+        out.psqtAccumulation = psqtAccumulation.data();
+        out.layer1           = layer1.data();
+        out.layer2           = layer2.data();
+    }
+
+    evaluator.evaluate(fens, out);
+
+    const auto now = Clock::now();
+    {
+        std::lock_guard<std::mutex> lk(statsMutex);
+        counters.batchSize.add(n);
+        counters.requests.add(requests.size());
+        for (auto& r : requests)
+            counters.latencyUs.add(std::uint64_t(
+              std::chrono::duration_cast<std::chrono::microseconds>(now - r.submitted).count()));
+    }
+
+    std::size_t first = 0;
+    for (auto& r : requests)
+    {
+        // The strings were moved out, the vector still has its size
+        r.done(out, first, r.fens.size());
+        first += r.fens.size();
+    }
+}
+
+
+DispatcherStats Dispatcher::stats() const {
+    std::lock_guard<std::mutex> lk(statsMutex);
+    return counters;
+}
+
+
+void Dispatcher::reset_stats() {
+    std::lock_guard<std::mutex> lk(statsMutex);
+    counters = DispatcherStats();
+}
+
+}  // namespace Stockfish::Batch
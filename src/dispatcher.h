@@ -0,0 +1,136 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DISPATCHER_H_INCLUDED
+#define DISPATCHER_H_INCLUDED
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "batch.h"
+
+namespace Stockfish::Batch {
+
+// Log-linear histogram of non-negative integers: exact below 16, then 8
+// buckets per power of two, so quantiles are within 12.5% of the true value.
+class Histogram {
+   public:
+    static constexpr int SubBuckets = 8;
+    static constexpr int Size       = 16 + (64 - 4) * SubBuckets;
+
+    void add(std::uint64_t value);
+    void merge(const Histogram& other);
+    void clear() { *this = Histogram(); }
+
+    std::uint64_t count() const { return total; }
+    std::uint64_t max() const { return maximum; }
+    double        mean() const { return total ? double(sum) / total : 0.0; }
+
+    // Upper end of the bucket holding the q-quantile, at most the maximum
+    std::uint64_t quantile(double q) const;
+
+    // Bucket i holds the values in [lower_bound(i), lower_bound(i + 1))
+    static std::uint64_t lower_bound(int i);
+    std::uint64_t        operator[](int i) const { return counts[i]; }
+
+   private:
+    std::array<std::uint64_t, Size> counts{};
+    std::uint64_t                   total = 0, sum = 0, maximum = 0;
+};
+
+struct DispatcherStats {
+    Histogram latencyUs;  // From submit() to the start of the callback
+    Histogram batchSize;  // Positions per batch
+    Histogram requests;   // Requests per batch
+};
+
+// Evaluates requests submitted from any thread on a background thread. All
+// requests pending when a batch starts are evaluated together, up to maxBatch
+// positions. With maxDelayUs = 0 a batch starts as soon as the thread is idle,
+// so under load many small requests share one batch while a lone request does
+// not wait for company. Otherwise requests are held until maxBatch positions
+// are pending or the oldest of them has waited maxDelayUs, trading a bounded
+// amount of latency for fuller batches.
+//
+// The callback of a request runs on the dispatcher thread once its batch is
+// done, and receives the batch outputs and the rows [first, first + count)
+// holding its positions. The outputs are only valid during the callback.
+class Dispatcher {
+   public:
+    using Callback = std::function<void(const Outputs& out, std::size_t first, std::size_t count)>;
+
+    Dispatcher(const Eval::NNUE::Networks& networks,
+               EvalCache*                  cache,
+               std::size_t                 threads,
+               std::size_t                 maxBatch,
+               std::uint64_t               maxDelayUs = 0);
+    ~Dispatcher();
+
+    // Throws std::invalid_argument, in the calling thread and without queueing
+    // the request, if a FEN is not well formed
+    void submit(std::vector<std::string> fens, bool activations, Callback done);
+
+    // Completes the pending requests and joins the dispatcher thread
+    void stop();
+
+    DispatcherStats stats() const;
+    void            reset_stats();
+
+   private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Request {
+        std::vector<std::string> fens;
+        bool                     activations;
+        Callback                 done;
+        Clock::time_point        submitted;
+    };
+
+    void idle_loop();
+    void dispatch(std::vector<Request>& requests);
+
+    Evaluator               evaluator;
+    std::size_t             maxBatch;
+    Clock::duration         maxDelay;
+    std::mutex              mutex;
+    std::condition_variable cv;
+    std::deque<Request>     pending;
+    std::size_t             pendingPositions = 0;
+    bool                    stopping         = false;
+    std::thread             thread;
+
+    mutable std::mutex statsMutex;
+    DispatcherStats    counters;
+
+    // Batch buffers, kept between batches
+    std::vector<float>        final, psqt, positional, accumulation, psqtAccumulation, layer1, layer2;
+    std::vector<std::uint8_t> smallNet;
+};
+
+}  // namespace Stockfish::Batch
+
+#endif  // #ifndef DISPATCHER_H_INCLUDED
@@ -0,0 +1,70 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DLPACK_H_INCLUDED
+#define DLPACK_H_INCLUDED
+
+#include <cstdint>
+
+// The subset of the DLPack ABI (https://github.com/dmlc/dlpack) needed to
+// write into tensors owned by other frameworks. Only the layout of these
+// structs matters, it is shared by all DLPack versions before 1.0, and by the
+// unversioned "dltensor" capsules that __dlpack__() returns by default.
+namespace Stockfish::DLPack {
+
+enum DeviceType : std::int32_t {
+    kDLCPU = 1
+};
+
+enum TypeCode : std::uint8_t {
+    kDLInt   = 0,
+    kDLUInt  = 1,
+    kDLFloat = 2,
+    kDLBool  = 6
+};
+
+struct Device {
+    DeviceType   deviceType;
+    std::int32_t deviceId;
+};
+
+struct DataType {
+    std::uint8_t  code;
+    std::uint8_t  bits;
+    std::uint16_t lanes;
+};
+
+struct Tensor {
+    void*         data;
+    Device        device;
+    std::int32_t  ndim;
+    DataType      dtype;
+    std::int64_t* shape;
+    std::int64_t* strides;  // In elements, nullptr for a compact row-major tensor
+    std::uint64_t byteOffset;
+};
+
+struct ManagedTensor {
+    Tensor dlTensor;
+    void*  managerCtx;
+    void (*deleter)(ManagedTensor* self);
+};
+
+}  // namespace Stockfish::DLPack
+
+#endif  // #ifndef DLPACK_H_INCLUDED
@@ -55,12 +55,14 @@ Engine::Engine(std::optional<std::string> path) :
     numaContext(NumaConfig::from_system()),
     states(new std::deque<StateInfo>(1)),
     threads(),
+    tt(std::make_shared<TranspositionTable>()),
     networks(
       numaContext,
       NN::Networks(
         NN::NetworkBig({EvalFileDefaultNameBig, "None", ""}, NN::EmbeddedNNUEType::BIG),
         NN::NetworkSmall({EvalFileDefaultNameSmall, "None", ""}, NN::EmbeddedNNUEType::SMALL))) {
     pos.set(StartFEN, false, &states->back());
+    tt->attach();
 
 
     options.add(  //
@@ -83,14 +85,23 @@ Engine::Engine(std::optional<std::string> path) :
       }));
 
     options.add(  //
-      "Hash", Option(16, 1, MaxHashMB, [this](const Option& o) {
-          set_tt_size(o);
+      "Hash", Option(16, 1, MaxHashMB, [this](const Option& o) -> std::optional<std::string> {
+          if (!set_tt_size(o))
+              return "Hash not resized: the table is shared with other engines";
           return std::nullopt;
       }));
 
     options.add(  //
-      "Clear Hash", Option([this](const Option&) {
+      "EvalCache", Option(0, 0, MaxHashMB, [this](const Option& o) {
+          evalCache.resize(size_t(int(o)));
+          return std::nullopt;
+      }));
+
+    options.add(  //
+      "Clear Hash", Option([this](const Option&) -> std::optional<std::string> {
           search_clear();
+          if (tt_shared() || tt->mapped())
+              return "Hash not cleared: the table is shared with other engines or loaded from a file";
           return std::nullopt;
       }));
 
@@ -144,6 +155,11 @@ Engine::Engine(std::optional<std::string> path) :
     resize_threads();
 }
 
+Engine::~Engine() {
+    wait_for_search_finished();
+    tt->detach();
+}
+
 std::uint64_t Engine::perft(const std::string& fen, Depth depth, bool isChess960) {
     verify_networks();
 
@@ -161,7 +177,10 @@ void Engine::stop() { threads.stop = true; }
 void Engine::search_clear() {
     wait_for_search_finished();
 
-    tt.clear(threads);
+    // Other engines may be searching with a shared table, and clearing a mapped
+    // one would zero its file, so those keep their entries
+    if (!tt_shared() && !tt->mapped())
+        tt->clear(threads);
     threads.clear();
 
     // @TODO wont work with multiple instances
@@ -235,18 +254,54 @@ void Engine::set_numa_config_from_option(const std::string& o) {
 
 void Engine::resize_threads() {
     threads.wait_for_search_finished();
-    threads.set(numaContext.get_numa_config(), {options, threads, tt, networks}, updateContext);
+    threads.set(numaContext.get_numa_config(), {options, threads, *tt, networks}, updateContext);
 
-    // Reallocate the hash with the new threadpool size
+    // Reallocate the hash with the new threadpool size, unless other engines use it
     set_tt_size(options["Hash"]);
     threads.ensure_network_replicated();
 }
 
-void Engine::set_tt_size(size_t mb) {
+bool Engine::set_tt_size(size_t mb) {
+    wait_for_search_finished();
+
+    if (tt->attached() > 1)
+        return false;
+
+    tt->rehash(mb, threads);
+    return true;
+}
+
+bool Engine::save_tt(const std::string& path, std::string& error) {
+    wait_for_search_finished();
+    return tt->save(path, error);
+}
+
+bool Engine::load_tt(const std::string& path, std::string& error) {
+    wait_for_search_finished();
+
+    if (tt->attached() > 1)
+    {
+        error = "the transposition table is shared with other engines";
+        return false;
+    }
+
+    return tt->load(path, error);
+}
+
+void Engine::share_tt(Engine& other) {
     wait_for_search_finished();
-    tt.resize(mb, threads);
+
+    tt->detach();
+    tt = other.tt;
+    tt->attach();
+
+    // The search workers hold on to the table they were created with
+    threads.set(numaContext.get_numa_config(), {options, threads, *tt, networks}, updateContext);
+    threads.ensure_network_replicated();
 }
 
+bool Engine::tt_shared() const { return tt->attached() > 1; }
+
 void Engine::set_ponderhit(bool b) { threads.main_manager()->ponder = b; }
 
 // network related
@@ -261,6 +316,7 @@ void Engine::load_networks() {
         networks_.big.load(binaryDirectory, options["EvalFile"]);
         networks_.small.load(binaryDirectory, options["EvalFileSmall"]);
     });
+    reset_evaluator();
     threads.clear();
     threads.ensure_network_replicated();
 }
@@ -268,6 +324,7 @@ void Engine::load_networks() {
 void Engine::load_big_network(const std::string& file) {
     networks.modify_and_replicate(
       [this, &file](NN::Networks& networks_) { networks_.big.load(binaryDirectory, file); });
+    reset_evaluator();
     threads.clear();
     threads.ensure_network_replicated();
 }
@@ -275,10 +332,16 @@ void Engine::load_big_network(const std::string& file) {
 void Engine::load_small_network(const std::string& file) {
     networks.modify_and_replicate(
       [this, &file](NN::Networks& networks_) { networks_.small.load(binaryDirectory, file); });
+    reset_evaluator();
     threads.clear();
     threads.ensure_network_replicated();
 }
 
+void Engine::reset_evaluator() {
+    evaluator.reset();
+    evalCache.clear();
+}
+
 void Engine::save_network(const std::pair<std::optional<std::string>, std::string> files[2]) {
     networks.modify_and_replicate([&files](NN::Networks& networks_) {
         networks_.big.save(files[0].first);
@@ -301,6 +364,38 @@ void Engine::trace_eval() const {
 const OptionsMap& Engine::get_options() const { return options; }
 OptionsMap&       Engine::get_options() { return options; }
 
+Batch::Stats Engine::evaluate_batch(const std::vector<std::string>& fens,
+                                    const Batch::Outputs&           out) {
+    verify_networks();
+
+    const size_t numThreads = size_t(int(options["Threads"]));
+
+    if (!evaluator)
+        evaluator = std::make_unique<Batch::Evaluator>(*networks, &evalCache, numThreads);
+    else if (evaluator->threads() != numThreads)
+        evaluator->set_threads(numThreads);
+
+    return evaluator->evaluate(fens, out);
+}
+
+std::vector<std::vector<Batch::PlyAnalysis>> Engine::analyze_games(
+  const std::vector<Batch::Game>& games, const Search::LimitsType& limits, size_t workers) {
+    wait_for_search_finished();
+    verify_networks();
+
+    return Batch::analyze_games(games, limits, workers ? workers : size_t(int(options["Threads"])),
+                                options, *tt, networks, numaContext.get_numa_config());
+}
+
+std::vector<std::vector<Batch::RootMoveAnalysis>> Engine::analyze_root_moves(
+  const std::vector<std::string>& fens, const Search::LimitsType& limits, size_t workers) {
+    wait_for_search_finished();
+    verify_networks();
+
+    return Batch::analyze_root_moves(fens, limits, workers ? workers : size_t(int(options["Threads"])),
+                                     options, *tt, networks, numaContext.get_numa_config());
+}
+
 std::string Engine::fen() const { return pos.fen(); }
 
 void Engine::flip() { pos.flip(); }
@@ -311,7 +406,7 @@ std::string Engine::visualize() const {
     return ss.str();
 }
 
-int Engine::get_hashfull(int maxAge) const { return tt.hashfull(maxAge); }
+int Engine::get_hashfull(int maxAge) const { return tt->hashfull(maxAge); }
 
 std::vector<std::pair<size_t, size_t>> Engine::get_bound_thread_count_by_numa_node() const {
     auto                                   counts = threads.get_bound_thread_count_by_numa_node();
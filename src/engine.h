@@ -22,12 +22,16 @@
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
 
+#include "analysis.h"
+#include "batch.h"
+#include "evalcache.h"
 #include "nnue/network.h"
 #include "numa.h"
 #include "position.h"
@@ -53,7 +57,7 @@ class Engine {
     Engine& operator=(const Engine&) = delete;
     Engine& operator=(Engine&&)      = delete;
 
-    ~Engine() { wait_for_search_finished(); }
+    ~Engine();
 
     std::uint64_t perft(const std::string& fen, Depth depth, bool isChess960);
 
@@ -71,8 +75,22 @@ class Engine {
 
     void set_numa_config_from_option(const std::string& o);
     void resize_threads();
-    void set_tt_size(size_t mb);
+    // Returns false, leaving the table as it is, if other engines share it
+    bool set_tt_size(size_t mb);
+    // Transposition table files, see TranspositionTable::save() and load(). A loaded
+    // table stays in use until the Hash or Threads option is changed, and is not
+    // cleared by search_clear(), which would zero the file.
+    bool save_tt(const std::string& path, std::string& error);
+    bool load_tt(const std::string& path, std::string& error);
+    // Searches with the transposition table of another engine from now on, see
+    // TranspositionTable::attach(). The shared table cannot be resized or loaded
+    // from a file, nor is it cleared by search_clear(), as the other engines may
+    // be searching with it.
+    void share_tt(Engine& other);
+    bool tt_shared() const;
     void set_ponderhit(bool);
+    // Clears the search state for a new game, and the transposition table if it
+    // is neither shared nor mapped from a file
     void search_clear();
 
     void set_on_update_no_moves(std::function<void(const InfoShort&)>&&);
@@ -93,6 +111,24 @@ class Engine {
 
     void trace_eval() const;
 
+    // Static evaluation of many positions on the batch evaluator, with as many
+    // threads as the Threads option and through the evaluation cache (EvalCache
+    // option, off by default), which is kept between calls and cleared when the
+    // networks change
+    Batch::Stats evaluate_batch(const std::vector<std::string>& fens, const Batch::Outputs& out);
+
+    // Searches the positions of games on single-threaded workers that share this
+    // engine's transposition table and networks, see Batch::analyze_games(). The
+    // limits must end each search (depth, nodes or movetime). 0 workers for as
+    // many as the Threads option.
+    std::vector<std::vector<Batch::PlyAnalysis>>
+    analyze_games(const std::vector<Batch::Game>& games, const Search::LimitsType& limits, size_t workers = 0);
+
+    // Searches every legal move of the positions on the same workers, see
+    // Batch::analyze_root_moves()
+    std::vector<std::vector<Batch::RootMoveAnalysis>> analyze_root_moves(
+      const std::vector<std::string>& fens, const Search::LimitsType& limits, size_t workers = 0);
+
     const OptionsMap& get_options() const;
     OptionsMap&       get_options();
 
@@ -108,6 +144,9 @@ class Engine {
     std::string                            thread_binding_information_as_string() const;
 
    private:
+    // The evaluator's extractors and the cached evaluations belong to the old networks
+    void reset_evaluator();
+
     const std::string binaryDirectory;
 
     NumaReplicationContext numaContext;
@@ -117,8 +156,10 @@ class Engine {
 
     OptionsMap                               options;
     ThreadPool                               threads;
-    TranspositionTable                       tt;
+    std::shared_ptr<TranspositionTable>      tt;
     LazyNumaReplicated<Eval::NNUE::Networks> networks;
+    EvalCache                                evalCache;
+    std::unique_ptr<Batch::Evaluator>        evaluator;  // Created on first use
 
     Search::SearchManager::UpdateContext  updateContext;
     std::function<void(std::string_view)> onVerifyNetworks;
@@ -0,0 +1,276 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "evalcache.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "memory.h"
+#include "misc.h"
+
+namespace Stockfish {
+
+// EvalCacheEntry is a 16 byte pair of 64-bit words. The data word is laid out as:
+//
+// final eval     16 bit
+// psqt           16 bit
+// positional     16 bit
+// small net       1 bit
+// activation     14 bit  (slot index + 1, 0 if none)
+// occupied        1 bit
+//
+// and the key word holds the position key xored with the data word.
+
+struct EvalCacheEntry {
+    std::atomic<std::uint64_t> keyXorData;
+    std::atomic<std::uint64_t> data;
+};
+
+static constexpr int ClusterSize = 4;
+
+struct EvalCacheCluster {
+    EvalCacheEntry entry[ClusterSize];
+};
+
+static_assert(sizeof(EvalCacheCluster) == 64, "Suboptimal EvalCacheCluster size");
+
+// Header in front of each activation blob. The sequence number is odd while the
+// slot is being written.
+struct EvalCacheSlot {
+    std::atomic<std::uint64_t> sequence;
+    std::atomic<Key>           key;
+};
+
+namespace {
+
+constexpr std::uint64_t SmallNetBit = 1ULL << 48;
+constexpr int           SlotShift   = 49;
+constexpr std::uint64_t SlotMask    = 0x3FFF;
+constexpr std::uint64_t OccupiedBit = 1ULL << 63;
+
+std::uint64_t pack16(Value v) {
+    return std::uint16_t(std::int16_t(std::clamp(v, Value(INT16_MIN), Value(INT16_MAX))));
+}
+
+Value unpack16(std::uint64_t d, int shift) { return Value(std::int16_t(std::uint16_t(d >> shift))); }
+
+}
+
+
+EvalCache::~EvalCache() {
+    aligned_large_pages_free(table);
+    aligned_large_pages_free(slots);
+}
+
+
+// Sets the size of the evaluation cache, measured in megabytes, and of its
+// optional ring of activation slots.
+void EvalCache::resize(std::size_t mbSize, std::size_t activationSlots, std::size_t activationSize) {
+    aligned_large_pages_free(table);
+    aligned_large_pages_free(slots);
+
+    table        = nullptr;
+    slots        = nullptr;
+    clusterCount = mbSize * 1024 * 1024 / sizeof(EvalCacheCluster);
+    slotCount    = clusterCount && activationSize ? std::min(activationSlots, MaxActivationSlots) : 0;
+    slotSize     = slotCount ? activationSize : 0;
+    slotStride   = slotCount ? (sizeof(EvalCacheSlot) + slotSize + 63) / 64 * 64 : 0;
+
+    if (clusterCount)
+    {
+        table = static_cast<EvalCacheCluster*>(
+          aligned_large_pages_alloc(clusterCount * sizeof(EvalCacheCluster)));
+
+        if (!table)
+        {
+            std::cerr << "Failed to allocate " << mbSize << "MB for evaluation cache." << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (slotCount)
+    {
+        slots = static_cast<char*>(aligned_large_pages_alloc(slotCount * slotStride));
+
+        if (!slots)
+        {
+            std::cerr << "Failed to allocate " << slotCount * slotStride / (1024 * 1024)
+                      << "MB for cached activations." << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    clear();
+}
+
+
+// Empties the cache and resets the hit/miss counters
+void EvalCache::clear() {
+    if (table)
+        std::memset(static_cast<void*>(table), 0, clusterCount * sizeof(EvalCacheCluster));
+
+    if (slots)
+        std::memset(slots, 0, slotCount * slotStride);
+
+    nextSlot  = 0;
+    hitCount  = 0;
+    missCount = 0;
+}
+
+
+std::size_t EvalCache::size_mb() const {
+    return (clusterCount * sizeof(EvalCacheCluster) + slotCount * slotStride) / (1024 * 1024);
+}
+
+
+int EvalCache::hashfull() const {
+    const std::size_t sample = std::min<std::size_t>(clusterCount, 1000);
+    std::size_t       cnt    = 0;
+
+    for (std::size_t i = 0; i < sample; ++i)
+        for (int j = 0; j < ClusterSize; ++j)
+            cnt += bool(table[i].entry[j].data.load(std::memory_order_relaxed) & OccupiedBit);
+
+    return sample ? int(cnt * 1000 / (sample * ClusterSize)) : 0;
+}
+
+
+EvalCacheEntry* EvalCache::first_entry(const Key key) const {
+    return &table[mul_hi64(key, clusterCount)].entry[0];
+}
+
+
+void EvalCache::prefetch(Key key) const {
+    if (enabled())
+        Stockfish::prefetch(first_entry(key));
+}
+
+
+EvalCacheSlot* EvalCache::slot(std::size_t idx) const {
+    return reinterpret_cast<EvalCacheSlot*>(slots + idx * slotStride);
+}
+
+
+// Copies the blob in slot idx if it still belongs to the given key and was not
+// being rewritten while we read it.
+bool EvalCache::read_slot(std::size_t idx, Key key, void* activations) const {
+
+    EvalCacheSlot*      s   = slot(idx);
+    const std::uint64_t seq = s->sequence.load(std::memory_order_acquire);
+
+    if ((seq & 1) || s->key.load(std::memory_order_relaxed) != key)
+        return false;
+
+    std::memcpy(activations, reinterpret_cast<const char*>(s) + sizeof(EvalCacheSlot), slotSize);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return s->sequence.load(std::memory_order_relaxed) == seq;
+}
+
+
+// Stores the blob in the next slot of the ring. Returns the slot index plus one,
+// or zero if another thread is writing the same slot right now.
+std::size_t EvalCache::write_slot(Key key, const void* activations) {
+
+    const std::size_t idx = nextSlot.fetch_add(1, std::memory_order_relaxed) % slotCount;
+    EvalCacheSlot*    s   = slot(idx);
+    std::uint64_t     seq = s->sequence.load(std::memory_order_relaxed);
+
+    if ((seq & 1)
+        || !s->sequence.compare_exchange_strong(seq, seq + 1, std::memory_order_acquire))
+        return 0;
+
+    s->key.store(key, std::memory_order_relaxed);
+    std::memcpy(reinterpret_cast<char*>(s) + sizeof(EvalCacheSlot), activations, slotSize);
+    s->sequence.store(seq + 2, std::memory_order_release);
+
+    return idx + 1;
+}
+
+
+// Looks up the key in the cache. Entries whose two words do not agree were
+// torn by a concurrent save() and are treated as a miss.
+bool EvalCache::probe(const Key key, EvalCacheData& data, void* activations) const {
+
+    if (!clusterCount)
+        return false;
+
+    const EvalCacheEntry* const tte = first_entry(key);
+
+    for (int i = 0; i < ClusterSize; ++i)
+    {
+        const std::uint64_t d = tte[i].data.load(std::memory_order_relaxed);
+
+        if (!(d & OccupiedBit) || (tte[i].keyXorData.load(std::memory_order_relaxed) ^ d) != key)
+            continue;
+
+        if (activations)
+        {
+            const std::size_t s = (d >> SlotShift) & SlotMask;
+
+            if (!s || !read_slot(s - 1, key, activations))
+                break;
+        }
+
+        data = EvalCacheData{unpack16(d, 0), unpack16(d, 16), unpack16(d, 32),
+                             bool(d & SmallNetBit)};
+        hitCount.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    missCount.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+
+// Stores the data for the key, replacing the entry with the same key, else an
+// empty entry, else an entry picked by the key bits. The race with concurrent
+// probes is benign thanks to the xor check.
+void EvalCache::save(const Key key, const EvalCacheData& data, const void* activations) {
+
+    if (!clusterCount)
+        return;
+
+    EvalCacheEntry* const tte     = first_entry(key);
+    EvalCacheEntry*       replace = &tte[(key >> 32) % ClusterSize];
+
+    for (int i = 0; i < ClusterSize; ++i)
+    {
+        const std::uint64_t d = tte[i].data.load(std::memory_order_relaxed);
+
+        if (!(d & OccupiedBit) || (tte[i].keyXorData.load(std::memory_order_relaxed) ^ d) == key)
+        {
+            replace = &tte[i];
+            break;
+        }
+    }
+
+    const std::size_t s = activations && slotCount ? write_slot(key, activations) : 0;
+
+    const std::uint64_t d = pack16(data.final) | pack16(data.psqt) << 16
+                          | pack16(data.positional) << 32 | (data.smallNet ? SmallNetBit : 0)
+                          | std::uint64_t(s) << SlotShift | OccupiedBit;
+
+    replace->data.store(d, std::memory_order_relaxed);
+    replace->keyXorData.store(key ^ d, std::memory_order_relaxed);
+}
+
+}  // namespace Stockfish
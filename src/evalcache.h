@@ -0,0 +1,115 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef EVALCACHE_H_INCLUDED
+#define EVALCACHE_H_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "types.h"
+
+namespace Stockfish {
+
+struct EvalCacheEntry;
+struct EvalCacheCluster;
+struct EvalCacheSlot;
+
+// The evaluation cache remembers static evaluations by position key, so that
+// positions seen again (repeated openings, transpositions, reruns of the same
+// dataset) skip the network entirely. It is shared by all threads and is laid
+// out like the TranspositionTable: an array of cache-line sized clusters, indexed
+// with mul_hi64 on the key.
+//
+// Unlike the TT, a torn read must never be returned as a hit, because there is no
+// search to correct a wrong value later. Each entry therefore stores the key xored
+// with its data (both 64-bit atomics), and a reader only accepts the entry if the
+// two words are consistent. This keeps probe/save lock-free.
+//
+// Optionally the cache also keeps a ring of activation slots. A slot holds an
+// opaque blob of fixed size (the caller decides what goes in it) and is
+// referenced from the entry through a 14-bit slot index packed into the data
+// word. Slots are recycled round-robin and protected by a sequence counter, so a
+// recycled or half-written slot is detected as an activation miss.
+
+// A copy of the data stored for a position
+struct EvalCacheData {
+    Value final;
+    Value psqt;
+    Value positional;
+    bool  smallNet;
+};
+
+class EvalCache {
+
+   public:
+    static constexpr std::size_t MaxActivationSlots = (1 << 14) - 1;
+
+    EvalCache() = default;
+    ~EvalCache();
+
+    EvalCache(const EvalCache&)            = delete;
+    EvalCache& operator=(const EvalCache&) = delete;
+
+    // Sets the size of the table in megabytes, plus an optional number of
+    // activation slots of activationSize bytes each. A size of 0 disables the cache.
+    // Not thread safe: no other thread may use the cache while resizing.
+    void resize(std::size_t mbSize, std::size_t activationSlots = 0, std::size_t activationSize = 0);
+    void clear();
+
+    bool enabled() const { return clusterCount != 0; }
+    bool stores_activations() const { return slotCount != 0; }
+
+    // Looks up the key. If activations is not null, the entry only counts as a hit
+    // when its activation slot is still valid, and the blob is copied there.
+    bool probe(Key key, EvalCacheData& data, void* activations = nullptr) const;
+    void save(Key key, const EvalCacheData& data, const void* activations = nullptr);
+
+    // Brings the cluster of the key into the cache ahead of a probe
+    void prefetch(Key key) const;
+
+    std::uint64_t hits() const { return hitCount.load(std::memory_order_relaxed); }
+    std::uint64_t misses() const { return missCount.load(std::memory_order_relaxed); }
+    std::size_t   size_mb() const;
+    std::size_t   activation_slots() const { return slotCount; }
+    std::size_t   activation_size() const { return slotSize; }
+    int           hashfull() const;  // Permille of sampled entries that are occupied
+
+   private:
+    EvalCacheEntry* first_entry(Key key) const;
+    EvalCacheSlot*  slot(std::size_t idx) const;
+    bool            read_slot(std::size_t idx, Key key, void* activations) const;
+    std::size_t     write_slot(Key key, const void* activations);
+
+    std::size_t       clusterCount = 0;
+    EvalCacheCluster* table        = nullptr;
+
+    std::size_t              slotCount  = 0;
+    std::size_t              slotSize   = 0;
+    std::size_t              slotStride = 0;
+    char*                    slots      = nullptr;
+    std::atomic<std::size_t> nextSlot{0};
+
+    alignas(64) mutable std::atomic<std::uint64_t> hitCount{0};
+    alignas(64) mutable std::atomic<std::uint64_t> missCount{0};
+};
+
+}  // namespace Stockfish
+
+#endif  // #ifndef EVALCACHE_H_INCLUDED
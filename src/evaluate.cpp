@@ -62,15 +62,25 @@ Value Eval::evaluate(const Eval::NNUE::Networks&    networks,
     auto [psqt, positional] = smallNet ? networks.small.evaluate(pos, accumulators, &caches.small)
                                        : networks.big.evaluate(pos, accumulators, &caches.big);
 
-    Value nnue = (125 * psqt + 131 * positional) / 128;
-
     // Re-evaluate the position when higher eval accuracy is worth the time spent
-    if (smallNet && (std::abs(nnue) < 236))
-    {
+    if (smallNet && needs_bignet(psqt, positional))
         std::tie(psqt, positional) = networks.big.evaluate(pos, accumulators, &caches.big);
-        nnue                       = (125 * psqt + 131 * positional) / 128;
-        smallNet                   = false;
-    }
+
+    return blend(pos, psqt, positional, optimism);
+}
+
+// Returns true when a small net score is close enough to equality that the
+// big net should be used instead.
+bool Eval::needs_bignet(Value psqt, Value positional) {
+    return std::abs((125 * psqt + 131 * positional) / 128) < 236;
+}
+
+// Turns the raw network outputs into the final evaluation. Split out of
+// evaluate() so that callers which run the networks themselves (e.g. to
+// extract activations) get exactly the same score.
+Value Eval::blend(const Position& pos, Value psqt, Value positional, int optimism) {
+
+    Value nnue = (125 * psqt + 131 * positional) / 128;
 
     // Blend optimism and eval with nnue complexity
     int nnueComplexity = std::abs(psqt - positional);
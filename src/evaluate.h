@@ -51,6 +51,8 @@ Value evaluate(const NNUE::Networks&          networks,
                Eval::NNUE::AccumulatorStack&  accumulators,
                Eval::NNUE::AccumulatorCaches& caches,
                int                            optimism);
+bool  needs_bignet(Value psqt, Value positional);
+Value blend(const Position& pos, Value psqt, Value positional, int optimism);
 }  // namespace Eval
 
 }  // namespace Stockfish
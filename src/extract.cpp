@@ -0,0 +1,252 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "extract.h"
+
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+
+#include "evalcache.h"
+#include "evaluate.h"
+#include "nnue/nnue_common.h"
+#include "nnue/nnue_feature_transformer.h"
+#include "position.h"
+
+namespace Stockfish::Extract {
+
+using namespace Eval::NNUE;
+
+namespace {
+
+// Undoes FeatureTransformer::permute_weights() on one perspective of the
+// accumulator: block j of each chunk holds the original block order[j].
+template<IndexType Dimensions>
+void unpermute(const std::int16_t* in, std::int16_t* out) {
+
+    constexpr auto&       order = FeatureTransformer<Dimensions>::PackusEpi16Order;
+    constexpr std::size_t Block = 16 / sizeof(std::int16_t);
+    constexpr std::size_t Chunk = Block * order.size();
+
+    static_assert(Dimensions % Chunk == 0);
+
+    for (std::size_t i = 0; i < Dimensions; i += Chunk)
+        for (std::size_t j = 0; j < order.size(); ++j)
+            std::memcpy(out + i + order[j] * Block, in + i + j * Block, 16);
+}
+
+// Finds the nonzero 4-byte blocks of the transformed features with the same
+// routine the first, sparse input layer uses, then the nonzero bytes in them.
+template<IndexType Dimensions>
+IndexType sparse_transformed(const std::uint8_t* transformed, std::uint16_t* index, std::uint8_t* value) {
+
+    IndexType count = 0;
+
+#if (USE_SSSE3 | (USE_NEON >= 8))
+    constexpr IndexType NumBlocks = Dimensions / 4;
+
+    alignas(CacheLineSize) std::uint8_t input[Dimensions];
+    std::uint16_t                       nnz[NumBlocks];
+    IndexType                           blocks;
+
+    std::memcpy(input, transformed, Dimensions);
+    Layers::find_nnz<NumBlocks>(reinterpret_cast<const std::int32_t*>(input), nnz, blocks);
+
+    #if defined(USE_AVX512ICL)
+    // Blocks come out in _mm512_packus_epi32() order there
+    std::sort(nnz, nnz + blocks);
+    #endif
+
+    for (IndexType b = 0; b < blocks; ++b)
+        for (IndexType i = nnz[b] * 4; i < nnz[b] * 4 + 4u; ++i)
+            if (input[i])
+            {
+                index[count] = std::uint16_t(i);
+                value[count] = input[i];
+                ++count;
+            }
+#else
+    for (IndexType i = 0; i < Dimensions; ++i)
+        if (transformed[i])
+        {
+            index[count] = std::uint16_t(i);
+            value[count] = transformed[i];
+            ++count;
+        }
+#endif
+
+    return count;
+}
+
+
+// Only the first line of each weight row is fetched; it is enough for the
+// hardware prefetcher to pick up the rest of the row once it is streamed.
+template<typename Transformer>
+void prefetch_rows(const Transformer& ft, const Position& pos) {
+
+    for (Color perspective : {WHITE, BLACK})
+    {
+        FeatureSet::IndexList active;
+        if (perspective == WHITE)
+            FeatureSet::append_active_indices<WHITE>(pos, active);
+        else
+            FeatureSet::append_active_indices<BLACK>(pos, active);
+
+        for (IndexType idx : active)
+        {
+            Stockfish::prefetch(&ft.weights[idx * Transformer::OutputDimensions]);
+            Stockfish::prefetch(&ft.psqtWeights[idx * PSQTBuckets]);
+        }
+    }
+}
+
+}
+
+
+void nonzero_mask(const std::uint8_t* values, std::size_t size, std::uint64_t* mask) {
+
+    std::fill_n(mask, (size + 63) / 64, 0);
+
+    std::size_t i = 0;
+
+#if defined(USE_AVX2)
+    const __m256i zero = _mm256_setzero_si256();
+
+    for (; i + 32 <= size; i += 32)
+    {
+        const __m256i  v    = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        const unsigned bits = ~unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, zero)));
+        mask[i / 64] |= std::uint64_t(bits) << (i % 64);
+    }
+#elif defined(USE_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 16 <= size; i += 16)
+    {
+        const __m128i  v    = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+        const unsigned bits = ~unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero))) & 0xFFFF;
+        mask[i / 64] |= std::uint64_t(bits) << (i % 64);
+    }
+#endif
+
+    for (; i < size; ++i)
+        mask[i / 64] |= std::uint64_t(values[i] != 0) << (i % 64);
+}
+
+
+IndexType sparse_transformed(const Activations& act, std::uint16_t* index, std::uint8_t* value) {
+    return act.dimensions == TransformedFeatureDimensionsBig
+           ? sparse_transformed<TransformedFeatureDimensionsBig>(act.transformed, index, value)
+           : sparse_transformed<TransformedFeatureDimensionsSmall>(act.transformed, index, value);
+}
+
+
+Key cache_key(const Position& pos) { return pos.key() ^ make_key(pos.rule50_count()); }
+
+
+Extractor::Extractor(const Networks& nets, EvalCache* cache) :
+    networks(nets),
+    evalCache(cache),
+    caches(std::make_unique<AccumulatorCaches>(nets)) {}
+
+
+// Evaluates the position from scratch, exactly like Eval::evaluate() with zero
+// optimism, and fills in the activations of the network whose output was used.
+Score Extractor::evaluate(const Position& pos, Activations* activations) {
+
+    const bool cacheActivations =
+      evalCache && evalCache->activation_size() == sizeof(Activations);
+    const Key key = evalCache ? cache_key(pos) : 0;
+
+    EvalCacheData data;
+    if (evalCache && (!activations || cacheActivations)
+        && evalCache->probe(key, data, activations))
+        return {data.final, data.psqt, data.positional, data.smallNet};
+
+    // Positions are unrelated, so there is nothing to update incrementally.
+    // The refresh caches still save most of the work between positions.
+    accumulators.reset();
+
+    bool smallNet           = Eval::use_smallnet(pos);
+    auto [psqt, positional] = smallNet ? run(networks.small, caches->small, pos, activations)
+                                       : run(networks.big, caches->big, pos, activations);
+
+    if (smallNet && Eval::needs_bignet(psqt, positional))
+    {
+        std::tie(psqt, positional) = run(networks.big, caches->big, pos, activations);
+        smallNet                   = false;
+    }
+
+    const Score score{Eval::blend(pos, psqt, positional, VALUE_ZERO), psqt, positional, smallNet};
+
+    if (evalCache)
+        evalCache->save(key, {score.final, score.psqt, score.positional, score.smallNet},
+                        cacheActivations ? activations : nullptr);
+
+    return score;
+}
+
+
+void Extractor::prefetch(const Position& pos) const {
+
+    if (evalCache)
+        evalCache->prefetch(cache_key(pos));
+
+    if (Eval::use_smallnet(pos))
+        prefetch_rows(networks.small.get_feature_transformer(), pos);
+    else
+        prefetch_rows(networks.big.get_feature_transformer(), pos);
+}
+
+
+template<typename Network, IndexType Dimensions>
+NetworkOutput Extractor::run(const Network&                        network,
+                             AccumulatorCaches::Cache<Dimensions>& cache,
+                             const Position&                       pos,
+                             Activations*                          activations) {
+
+    using Arch = std::decay_t<decltype(network.get_network(0))>;
+
+    alignas(CacheLineSize)
+      TransformedFeatureType transformed[FeatureTransformer<Dimensions>::BufferSize];
+    typename Arch::Buffer buffer;
+
+    const int  bucket = (pos.count<ALL_PIECES>() - 1) / 4;
+    const auto psqt =
+      network.get_feature_transformer().transform(pos, accumulators, &cache, transformed, bucket);
+    const auto positional = network.get_network(bucket).propagate(transformed, buffer);
+
+    if (activations)
+    {
+        const auto& acc = accumulators.latest().template acc<Dimensions>();
+
+        activations->dimensions = Dimensions;
+        unpermute<Dimensions>(acc.accumulation[WHITE], activations->accumulation[WHITE]);
+        unpermute<Dimensions>(acc.accumulation[BLACK], activations->accumulation[BLACK]);
+        std::memcpy(activations->psqtAccumulation, acc.psqtAccumulation,
+                    sizeof(acc.psqtAccumulation));
+        std::memcpy(activations->transformed, transformed, Dimensions);
+        std::memcpy(activations->layer1, buffer.ac_sqr_0_out, Layer1Size);
+        std::memcpy(activations->layer2, buffer.ac_1_out, Layer2Size);
+    }
+
+    return {static_cast<Value>(psqt / OutputScale), static_cast<Value>(positional / OutputScale)};
+}
+
+}  // namespace Stockfish::Extract
@@ -0,0 +1,117 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef EXTRACT_H_INCLUDED
+#define EXTRACT_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "nnue/network.h"
+#include "nnue/nnue_accumulator.h"
+#include "nnue/nnue_architecture.h"
+#include "types.h"
+
+namespace Stockfish {
+
+class EvalCache;
+class Position;
+
+namespace Extract {
+
+using Eval::NNUE::IndexType;
+
+constexpr IndexType MaxDimensions = Eval::NNUE::TransformedFeatureDimensionsBig;
+constexpr int       Layer1Size    = Eval::NNUE::L2Big * 2;
+constexpr int       Layer2Size    = Eval::NNUE::L3Big;
+
+static_assert(Eval::NNUE::L2Small == Eval::NNUE::L2Big && Eval::NNUE::L3Small == Eval::NNUE::L3Big,
+              "Layer buffers are shared between the big and small network");
+
+// Final evaluation of a position and the raw network outputs it was blended from.
+// All values are from the point of view of the side to move.
+struct Score {
+    Value final;
+    Value psqt;
+    Value positional;
+    bool  smallNet;
+};
+
+// Internal activations of the network that produced a Score. Only the first
+// `dimensions` neurons of the per-network arrays are meaningful. The accumulator
+// is stored in file order, i.e. with the SIMD weight permutation undone, so that
+// neuron indices are stable across builds.
+struct Activations {
+    IndexType    dimensions;
+    std::int16_t accumulation[COLOR_NB][MaxDimensions];
+    std::int32_t psqtAccumulation[COLOR_NB][Eval::NNUE::PSQTBuckets];
+    std::uint8_t transformed[MaxDimensions];
+    std::uint8_t layer1[Layer1Size];
+    std::uint8_t layer2[Layer2Size];
+};
+
+// Writes the nonzero transformed features of `act` as (index, value) pairs in
+// increasing index order and returns their number. Both arrays must have room
+// for act.dimensions entries.
+IndexType sparse_transformed(const Activations& act, std::uint16_t* index, std::uint8_t* value);
+
+// Sets bit i of mask (bit i % 64 of word i / 64) when values[i] is nonzero, and
+// clears the other bits of the ceil(size / 64) words.
+void nonzero_mask(const std::uint8_t* values, std::size_t size, std::uint64_t* mask);
+
+// The key under which evaluations are cached. Position::key() only folds the
+// 50-move counter in coarsely, while the final score depends on its exact value.
+Key cache_key(const Position& pos);
+
+// Extractor evaluates independent positions and optionally exports the network
+// activations, in a single pass over the networks. It holds the accumulator stack
+// and the refresh caches, which are expensive to set up, so each thread should
+// keep one around and reuse it. The evaluation cache, if any, is shared.
+class Extractor {
+   public:
+    explicit Extractor(const Eval::NNUE::Networks& networks, EvalCache* cache = nullptr);
+
+    Extractor(const Extractor&)            = delete;
+    Extractor& operator=(const Extractor&) = delete;
+
+    Score evaluate(const Position& pos, Activations* activations = nullptr);
+
+    // Prefetches the first memory evaluate() will touch for pos, to be called a
+    // position ahead: its evaluation cache entry and the feature transformer
+    // rows of its active features.
+    void prefetch(const Position& pos) const;
+
+   private:
+    template<typename Network, IndexType Dimensions>
+    Eval::NNUE::NetworkOutput run(const Network&                                    network,
+                                  Eval::NNUE::AccumulatorCaches::Cache<Dimensions>& cache,
+                                  const Position&                                   pos,
+                                  Activations*                                      activations);
+
+    const Eval::NNUE::Networks&                    networks;
+    EvalCache*                                     evalCache;
+    Eval::NNUE::AccumulatorStack                   accumulators;
+    std::unique_ptr<Eval::NNUE::AccumulatorCaches> caches;
+};
+
+}  // namespace Extract
+
+}  // namespace Stockfish
+
+#endif  // #ifndef EXTRACT_H_INCLUDED
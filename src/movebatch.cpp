@@ -0,0 +1,140 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "movebatch.h"
+
+#include <algorithm>
+
+#include "batch.h"
+#include "movegen.h"
+#include "position.h"
+
+namespace Stockfish::Batch {
+
+namespace {
+
+// Flags of a move, packed in one byte while they sit in the thread buffers
+enum MoveFlag : std::uint8_t {
+    FLAG_CAPTURE  = 1,
+    FLAG_CHECK    = 2,
+    FLAG_SEE_GE_0 = 4,
+    FLAG_SEE_GT_0 = 8
+};
+
+std::uint8_t flags_of(const Position& pos, Move m) {
+    return (pos.capture(m) ? FLAG_CAPTURE : 0) | (pos.gives_check(m) ? FLAG_CHECK : 0)
+         | (pos.see_ge(m, 0) ? FLAG_SEE_GE_0 : 0) | (pos.see_ge(m, 1) ? FLAG_SEE_GT_0 : 0);
+}
+
+}
+
+
+MoveGenerator::MoveGenerator(std::size_t threads) { set_threads(threads); }
+
+
+void MoveGenerator::set_threads(std::size_t threads) {
+    buffers.resize(std::max<std::size_t>(1, threads));
+}
+
+
+std::size_t MoveGenerator::generate(const std::vector<std::string>& input, bool withFlags) {
+
+    // Checked before the buffers of the last call are dropped
+    const std::vector<std::string> fens = checked_fens(input);
+    const std::size_t              n    = fens.size();
+
+    for (auto& b : buffers)
+    {
+        b.moves.clear();
+        b.flags.clear();
+    }
+
+    rows.assign(n, Row{});
+    hasFlags = withFlags;
+
+    parallel_for(buffers.size(), n, [&](std::size_t t, std::size_t i) {
+        StateInfo st;
+        Position  pos;
+        pos.set(fens[i], false, &st);
+
+        Buffer&         b = buffers[t];
+        MoveList<LEGAL> moveList(pos);
+
+        rows[i] = {std::uint32_t(t), std::uint32_t(moveList.size()), b.moves.size()};
+
+        for (const Move m : moveList)
+        {
+            b.moves.push_back(m.raw());
+            if (withFlags)
+                b.flags.push_back(flags_of(pos, m));
+        }
+    });
+
+    offsets.resize(n + 1);
+    offsets[0] = 0;
+    for (std::size_t i = 0; i < n; ++i)
+        offsets[i + 1] = offsets[i] + rows[i].count;
+
+    return total();
+}
+
+
+void MoveGenerator::write(const MoveOutputs& out) const {
+
+    const std::size_t n = rows.size();
+
+    if (out.offsets)
+        std::copy(offsets.begin(), offsets.end(), out.offsets);
+
+    parallel_for(buffers.size(), n, [&](std::size_t, std::size_t i) {
+        const Buffer&     b   = buffers[rows[i].thread];
+        const std::size_t src = rows[i].start;
+        const std::size_t dst = std::size_t(offsets[i]);
+
+        for (std::size_t k = 0; k < rows[i].count; ++k)
+        {
+            const Move m(b.moves[src + k]);
+
+            if (out.moves)
+                out.moves[dst + k] = m.raw();
+
+            if (out.decoded)
+            {
+                std::int16_t* d = out.decoded + (dst + k) * 4;
+                d[0]            = m.from_sq();
+                d[1]            = m.to_sq();
+                d[2]            = m.type_of() == PROMOTION ? m.promotion_type() : NO_PIECE_TYPE;
+                d[3]            = m.type_of() >> 14;
+            }
+
+            if (!hasFlags)
+                continue;
+
+            const std::uint8_t f = b.flags[src + k];
+
+            if (out.capture)
+                out.capture[dst + k] = bool(f & FLAG_CAPTURE);
+            if (out.givesCheck)
+                out.givesCheck[dst + k] = bool(f & FLAG_CHECK);
+            if (out.see)
+                out.see[dst + k] = (f & FLAG_SEE_GT_0) ? 1 : (f & FLAG_SEE_GE_0) ? 0 : -1;
+        }
+    });
+}
+
+}  // namespace Stockfish::Batch
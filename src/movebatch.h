@@ -0,0 +1,82 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MOVEBATCH_H_INCLUDED
+#define MOVEBATCH_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Stockfish::Batch {
+
+// Destination buffers of a batch move generation. Moves are stored in CSR form:
+// the moves of position i are rows [offsets[i], offsets[i + 1]) of the per-move
+// arrays. Null pointers are skipped.
+struct MoveOutputs {
+    std::int64_t*  offsets    = nullptr;  // [n + 1]
+    std::uint16_t* moves      = nullptr;  // [total] raw Move encoding
+    std::int16_t*  decoded    = nullptr;  // [total][4] from, to, promotion, MoveType >> 14
+    std::uint8_t*  capture    = nullptr;  // [total] Position::capture()
+    std::uint8_t*  givesCheck = nullptr;  // [total] Position::gives_check()
+    std::int8_t*   see        = nullptr;  // [total] sign of the static exchange evaluation
+};
+
+// Generates the legal moves of many positions on a set of worker threads. This
+// is done in two steps, so that the caller can size the output buffers: the
+// moves are first generated into per-thread buffers, then copied out.
+class MoveGenerator {
+   public:
+    explicit MoveGenerator(std::size_t threads);
+
+    void        set_threads(std::size_t threads);
+    std::size_t threads() const { return buffers.size(); }
+
+    // Returns the total number of legal moves. The flags (capture, check and SEE)
+    // are only computed if requested, as they cost more than the generation.
+    // Throws std::invalid_argument if a FEN is not well formed.
+    std::size_t generate(const std::vector<std::string>& fens, bool withFlags);
+
+    std::size_t positions() const { return rows.size(); }
+    std::size_t total() const { return offsets.empty() ? 0 : std::size_t(offsets.back()); }
+
+    // Copies the moves of the last generate() call, flags only if they were computed
+    void write(const MoveOutputs& out) const;
+
+   private:
+    struct Buffer {
+        std::vector<std::uint16_t> moves;
+        std::vector<std::uint8_t>  flags;
+    };
+
+    struct Row {
+        std::uint32_t thread;
+        std::uint32_t count;
+        std::size_t   start;
+    };
+
+    std::vector<Buffer>       buffers;
+    std::vector<Row>          rows;
+    std::vector<std::int64_t> offsets;
+    bool                      hasFlags = false;
+};
+
+}  // namespace Stockfish::Batch
+
+#endif  // #ifndef MOVEBATCH_H_INCLUDED
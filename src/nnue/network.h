@@ -80,6 +80,7 @@ class Network {
     // Public accessors for Python bindings to extract intermediate layers
     const Arch& get_network(int bucket) const { return network[bucket]; }
     const Transformer& get_feature_transformer() const { return *featureTransformer; }
+    const std::string& loaded_file() const { return evalFile.current; }  // Empty if none
 
    private:
     void load_user_net(const std::string&, const std::string&);
@@ -0,0 +1,66 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef NNUE_CONTEXT_H_INCLUDED
+#define NNUE_CONTEXT_H_INCLUDED
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "batch.h"
+#include "evalcache.h"
+#include "nnue_interface.h"
+#include "server.h"
+
+// State behind an nnue_context handle. C callers only see the handle, while
+// the Python bindings, which are built into the same module, use the members
+// directly for the options the C API does not offer. Whoever uses the
+// evaluator or replaces the networks holds the mutex.
+struct nnue_context {
+    explicit nnue_context(std::size_t threads);
+
+    // Loads both networks (the default ones for null paths) and creates the
+    // evaluator for them. Returns false with `error` set on failure.
+    bool load_networks(const char* bigPath, const char* smallPath);
+
+    // Run on the evaluator and update the counters
+    Stockfish::Batch::Stats evaluate(const std::vector<std::string>& fens,
+                                     const Stockfish::Batch::Outputs& out,
+                                     bool                             dedup,
+                                     bool                             tablebases = false);
+    std::size_t             evaluate_trajectory(const std::string&               fen,
+                                                const std::vector<std::string>&  moves,
+                                                const Stockfish::Batch::Outputs& out);
+
+    std::unique_ptr<Stockfish::Eval::NNUE::Networks> networks;
+    Stockfish::EvalCache                             cache;
+    std::unique_ptr<Stockfish::Batch::Evaluator>     evaluator;
+    std::size_t                                      threads;
+    std::mutex                                       mutex;
+    std::string                                      error;
+    nnue_stats                                       counters{};
+
+    // Socket server on the networks and the cache, which therefore stay as they
+    // are while it runs. Declared last, so that it stops before they go away.
+    std::unique_ptr<Stockfish::Batch::Server> server;
+};
+
+#endif  // #ifndef NNUE_CONTEXT_H_INCLUDED
@@ -0,0 +1,320 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "nnue_context.h"
+
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include "bitboard.h"
+#include "evaluate.h"
+#include "extract.h"
+#include "position.h"
+
+using namespace Stockfish;
+
+static_assert(NNUE_ACCUMULATION_WIDTH == Extract::MaxDimensions
+                && NNUE_PSQT_BUCKETS == Eval::NNUE::PSQTBuckets
+                && NNUE_LAYER1_WIDTH == Extract::Layer1Size && NNUE_LAYER2_WIDTH == Extract::Layer2Size,
+              "The C API row widths must match the networks");
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+Batch::Outputs to_outputs(const nnue_outputs& o) {
+    Batch::Outputs out;
+    out.final            = o.eval;
+    out.psqt             = o.eval_psqt;
+    out.positional       = o.eval_positional;
+    out.smallNet         = o.small_net;
+    out.accumulation     = o.accumulation;
+    out.psqtAccumulation = o.psqt_accumulation;
+    out.layer1           = o.layer1;
+    out.layer2           = o.layer2;
+    return out;
+}
+
+// Runs a call with the context locked, turning exceptions into status codes.
+// Positions that are not well formed throw std::invalid_argument.
+template<typename Call>
+nnue_status guarded(nnue_context* ctx, const Call& call) {
+
+    if (!ctx)
+        return NNUE_ERROR_ARGUMENT;
+
+    std::lock_guard<std::mutex> lk(ctx->mutex);
+    ctx->error.clear();
+
+    try
+    {
+        return call();
+    } catch (const std::invalid_argument& e)
+    {
+        ctx->error = e.what();
+        return NNUE_ERROR_ARGUMENT;
+    } catch (const std::bad_alloc&)
+    {
+        ctx->error = "out of memory";
+    } catch (const std::exception& e)
+    {
+        ctx->error = e.what();
+    }
+    return NNUE_ERROR_INTERNAL;
+}
+
+nnue_status fail(nnue_context* ctx, nnue_status status, std::string message) {
+    ctx->error = std::move(message);
+    return status;
+}
+
+}
+
+
+nnue_context::nnue_context(std::size_t numThreads) :
+    threads(numThreads ? numThreads : std::max(1u, std::thread::hardware_concurrency())) {
+
+    static std::once_flag initialized;
+    std::call_once(initialized, [] {
+        Bitboards::init();
+        Position::init();
+    });
+}
+
+
+bool nnue_context::load_networks(const char* bigPath, const char* smallPath) {
+
+    const std::string big   = bigPath ? bigPath : EvalFileDefaultNameBig;
+    const std::string small = smallPath ? smallPath : EvalFileDefaultNameSmall;
+
+    Eval::NNUE::NetworkBig   networkBig({EvalFileDefaultNameBig, "", ""}, Eval::NNUE::EmbeddedNNUEType::BIG);
+    Eval::NNUE::NetworkSmall networkSmall({EvalFileDefaultNameSmall, "", ""},
+                                          Eval::NNUE::EmbeddedNNUEType::SMALL);
+
+    networkBig.load("", big);
+    networkSmall.load("", small);
+
+    if (networkBig.loaded_file() != big || networkSmall.loaded_file() != small)
+    {
+        error = "cannot load the network " + (networkBig.loaded_file() != big ? big : small);
+        return false;
+    }
+
+    // The evaluator's extractors hold on to the networks, so both are replaced
+    evaluator.reset();
+    networks  = std::make_unique<Eval::NNUE::Networks>(std::move(networkBig), std::move(networkSmall));
+    evaluator = std::make_unique<Batch::Evaluator>(*networks, &cache, threads);
+
+    // Cached results are keyed by position only and belong to the old networks
+    cache.clear();
+    return true;
+}
+
+
+Batch::Stats nnue_context::evaluate(const std::vector<std::string>& fens,
+                                    const Batch::Outputs&           out,
+                                    bool                            dedup,
+                                    bool                            tablebases) {
+
+    const auto         start = Clock::now();
+    const Batch::Stats stats = evaluator->evaluate(fens, out, dedup, tablebases);
+
+    ++counters.calls;
+    counters.positions += stats.positions;
+    counters.evaluated += stats.evaluated;
+    counters.duplicates += stats.saved;
+    counters.seconds += std::chrono::duration<double>(Clock::now() - start).count();
+    return stats;
+}
+
+
+std::size_t nnue_context::evaluate_trajectory(const std::string&              fen,
+                                              const std::vector<std::string>& moves,
+                                              const Batch::Outputs&           out) {
+
+    const auto        start = Clock::now();
+    const std::size_t rows  = evaluator->evaluate_trajectory(fen, moves, out);
+
+    ++counters.calls;
+    counters.positions += rows;
+    counters.evaluated += rows;
+    counters.seconds += std::chrono::duration<double>(Clock::now() - start).count();
+    return rows;
+}
+
+
+extern "C" {
+
+uint32_t nnue_api_version(void) { return NNUE_API_VERSION; }
+
+
+nnue_context* nnue_create(size_t threads) {
+    try
+    {
+        return new nnue_context(threads);
+    } catch (...)
+    {
+        return nullptr;
+    }
+}
+
+
+void nnue_destroy(nnue_context* ctx) { delete ctx; }
+
+
+nnue_status nnue_load_networks(nnue_context* ctx, const char* big_path, const char* small_path) {
+    return guarded(ctx, [&] {
+        if (ctx->server)
+            return fail(ctx, NNUE_ERROR_SERVER, "the server uses the networks, stop it first");
+        return ctx->load_networks(big_path, small_path) ? NNUE_OK : NNUE_ERROR_NETWORK;
+    });
+}
+
+
+nnue_status nnue_set_eval_cache(nnue_context* ctx, size_t megabytes) {
+    return guarded(ctx, [&] {
+        if (ctx->server)
+            return fail(ctx, NNUE_ERROR_SERVER, "the server uses the cache, stop it first");
+        ctx->cache.resize(megabytes);
+        return NNUE_OK;
+    });
+}
+
+
+nnue_status nnue_evaluate_batch(
+  nnue_context* ctx, const char* const* fens, size_t count, int dedup, const nnue_outputs* out) {
+    return guarded(ctx, [&] {
+        if (!out || (count && !fens))
+            return fail(ctx, NNUE_ERROR_ARGUMENT, "null fens or outputs");
+        if (!ctx->evaluator)
+            return fail(ctx, NNUE_ERROR_NETWORK, "no networks loaded");
+
+        std::vector<std::string> positions(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (!fens[i])
+                return fail(ctx, NNUE_ERROR_ARGUMENT, "null fen at index " + std::to_string(i));
+            positions[i] = fens[i];
+        }
+
+        ctx->evaluate(positions, to_outputs(*out), dedup != 0);
+        return NNUE_OK;
+    });
+}
+
+
+nnue_status nnue_evaluate_trajectory(nnue_context*       ctx,
+                                     const char*         fen,
+                                     const char* const*  moves,
+                                     size_t              count,
+                                     const nnue_outputs* out,
+                                     size_t*             rows) {
+    return guarded(ctx, [&] {
+        if (rows)
+            *rows = 0;
+        if (!fen || !out || (count && !moves))
+            return fail(ctx, NNUE_ERROR_ARGUMENT, "null fen, moves or outputs");
+        if (!ctx->evaluator)
+            return fail(ctx, NNUE_ERROR_NETWORK, "no networks loaded");
+
+        std::vector<std::string> line(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (!moves[i])
+                return fail(ctx, NNUE_ERROR_ARGUMENT, "null move at index " + std::to_string(i));
+            line[i] = moves[i];
+        }
+
+        const std::size_t written = ctx->evaluate_trajectory(fen, line, to_outputs(*out));
+        if (rows)
+            *rows = written;
+
+        if (written < count + 1)
+            return fail(ctx, NNUE_ERROR_MOVE,
+                        "illegal move " + line[written - 1] + " at index " + std::to_string(written - 1));
+        return NNUE_OK;
+    });
+}
+
+
+nnue_status nnue_server_start(nnue_context* ctx, const char* path, const nnue_server_config* config) {
+    return guarded(ctx, [&] {
+        if (!path)
+            return fail(ctx, NNUE_ERROR_ARGUMENT, "null path");
+        if (!ctx->networks)
+            return fail(ctx, NNUE_ERROR_NETWORK, "no networks loaded");
+        if (ctx->server)
+            return fail(ctx, NNUE_ERROR_SERVER, "the server is already running");
+
+        const nnue_server_config given = config ? *config : nnue_server_config{};
+        Batch::ServerConfig      cfg;
+
+        cfg.threads    = given.threads ? given.threads : ctx->threads;
+        cfg.maxDelayUs = given.max_delay_us;
+        if (given.max_batch)
+            cfg.maxBatch = given.max_batch;
+        if (given.max_in_flight)
+            cfg.maxInFlight = given.max_in_flight;
+
+        auto server = std::make_unique<Batch::Server>(*ctx->networks, &ctx->cache, cfg);
+        if (!server->start(path))
+            return fail(ctx, NNUE_ERROR_SERVER, server->error());
+
+        ctx->server = std::move(server);
+        return NNUE_OK;
+    });
+}
+
+
+nnue_status nnue_server_stop(nnue_context* ctx) {
+    return guarded(ctx, [&] {
+        ctx->server.reset();
+        return NNUE_OK;
+    });
+}
+
+
+nnue_status nnue_get_stats(nnue_context* ctx, nnue_stats* stats) {
+    return guarded(ctx, [&] {
+        if (!stats)
+            return fail(ctx, NNUE_ERROR_ARGUMENT, "null stats");
+
+        *stats              = ctx->counters;
+        stats->cache_hits   = ctx->cache.hits();
+        stats->cache_misses = ctx->cache.misses();
+        return NNUE_OK;
+    });
+}
+
+
+void nnue_reset_stats(nnue_context* ctx) {
+    guarded(ctx, [&] {
+        ctx->counters = nnue_stats{};
+        return NNUE_OK;
+    });
+}
+
+
+const char* nnue_last_error(nnue_context* ctx) { return ctx ? ctx->error.c_str() : "null context"; }
+
+}  // extern "C"
@@ -0,0 +1,159 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+  Plain C interface of the extraction engine, built as libnnue_interface. A
+  context owns a pair of networks, an evaluation cache and a multithreaded
+  batch evaluator. Functions taking a context may be called from any thread;
+  calls on the same context are serialized.
+
+  Scores are in pawns (Value / 100) from the point of view of the side to
+  move. Output buffers belong to the caller and hold one row per position;
+  NULL buffers are not written.
+*/
+
+#ifndef NNUE_INTERFACE_H_INCLUDED
+#define NNUE_INTERFACE_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32) && !defined(NNUE_INTERFACE_STATIC)
+    #if defined(NNUE_INTERFACE_BUILD)
+        #define NNUE_API __declspec(dllexport)
+    #else
+        #define NNUE_API __declspec(dllimport)
+    #endif
+#elif defined(__GNUC__)
+    #define NNUE_API __attribute__((visibility("default")))
+#else
+    #define NNUE_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NNUE_API_VERSION 2
+
+typedef struct nnue_context nnue_context;
+
+typedef enum nnue_status {
+    NNUE_OK,
+    NNUE_ERROR_ARGUMENT,  /* A null pointer or an invalid value */
+    NNUE_ERROR_NETWORK,   /* No networks loaded, or a network file could not be loaded */
+    NNUE_ERROR_MOVE,      /* Illegal move in a trajectory; the rows before it were written */
+    NNUE_ERROR_INTERNAL,  /* Out of memory or another failure, see nnue_last_error() */
+    NNUE_ERROR_SERVER     /* The server cannot start, or is running and blocks the call */
+} nnue_status;
+
+/* Row widths of the activation buffers */
+#define NNUE_ACCUMULATION_WIDTH 3072 /* Per perspective */
+#define NNUE_PSQT_BUCKETS 8          /* Per perspective */
+#define NNUE_LAYER1_WIDTH 30
+#define NNUE_LAYER2_WIDTH 32
+
+typedef struct nnue_outputs {
+    float*   eval;              /* [n] */
+    float*   eval_psqt;         /* [n] */
+    float*   eval_positional;   /* [n] */
+    uint8_t* small_net;         /* [n] 1 if the small network was used */
+    float*   accumulation;      /* [n][2][NNUE_ACCUMULATION_WIDTH], white then black */
+    float*   psqt_accumulation; /* [n][2][NNUE_PSQT_BUCKETS] */
+    float*   layer1;            /* [n][NNUE_LAYER1_WIDTH] */
+    float*   layer2;            /* [n][NNUE_LAYER2_WIDTH] */
+} nnue_outputs;
+
+/* Counters since the context was created or nnue_reset_stats() was called */
+typedef struct nnue_stats {
+    uint64_t calls;        /* Batch and trajectory evaluations */
+    uint64_t positions;    /* Rows written */
+    uint64_t evaluated;    /* Positions that went through the networks */
+    uint64_t duplicates;   /* Rows copied from an identical position of the same batch */
+    uint64_t cache_hits;   /* Of the evaluation cache, since it was last resized */
+    uint64_t cache_misses;
+    double   seconds;      /* Wall time spent evaluating */
+} nnue_stats;
+
+/* Evaluation server settings; zero fields take the defaults */
+typedef struct nnue_server_config {
+    size_t   threads;       /* Evaluation threads, default the context's */
+    size_t   max_batch;     /* Positions per batch, default 1024 */
+    uint64_t max_delay_us;  /* Wait for fuller batches, default 0: evaluate when idle */
+    size_t   max_in_flight; /* Unanswered requests per connection, default 64 */
+} nnue_server_config;
+
+NNUE_API uint32_t nnue_api_version(void);
+
+/* Creates a context evaluating on `threads` threads (0 for all CPUs), without
+   networks. Returns NULL if it cannot be allocated. */
+NNUE_API nnue_context* nnue_create(size_t threads);
+NNUE_API void          nnue_destroy(nnue_context* ctx);
+
+/* Loads the big and the small network from files, replacing loaded ones and
+   clearing the evaluation cache. NULL paths load the default networks, from
+   $NNUE_DIR or the working directory. Fails with NNUE_ERROR_SERVER while the
+   server runs. */
+NNUE_API nnue_status nnue_load_networks(nnue_context* ctx, const char* big_path, const char* small_path);
+
+/* Resizes (or with 0 MB disables) the evaluation cache and clears it. Fails
+   with NNUE_ERROR_SERVER while the server runs. */
+NNUE_API nnue_status nnue_set_eval_cache(nnue_context* ctx, size_t megabytes);
+
+/* Evaluates `count` positions given as FEN strings. With dedup, identical
+   positions are evaluated once and their rows copied. If a FEN is not well
+   formed, nothing is evaluated and NNUE_ERROR_ARGUMENT is returned. */
+NNUE_API nnue_status nnue_evaluate_batch(nnue_context*       ctx,
+                                         const char* const*  fens,
+                                         size_t              count,
+                                         int                 dedup,
+                                         const nnue_outputs* out);
+
+/* Evaluates the position given by fen, then the one after each of the
+   `count` moves (UCI notation), into count + 1 rows. *rows receives the
+   number of rows written, fewer if a move is illegal. A FEN that is not well
+   formed returns NNUE_ERROR_ARGUMENT. */
+NNUE_API nnue_status nnue_evaluate_trajectory(nnue_context*       ctx,
+                                              const char*         fen,
+                                              const char* const*  moves,
+                                              size_t              count,
+                                              const nnue_outputs* out,
+                                              size_t*             rows);
+
+/* Serves the context's networks and evaluation cache on a Unix domain socket
+   at path (Linux and macOS), on background threads, so that other processes
+   can evaluate positions. The binary protocol is the one of the Python
+   module's Server, see the README. NULL config for the defaults. A stale
+   socket file at path is replaced, anything else fails. */
+NNUE_API nnue_status nnue_server_start(nnue_context* ctx, const char* path, const nnue_server_config* config);
+
+/* Stops accepting, answers the requests already read, then closes the
+   connections and removes the socket file. nnue_destroy() also stops it. */
+NNUE_API nnue_status nnue_server_stop(nnue_context* ctx);
+
+NNUE_API nnue_status nnue_get_stats(nnue_context* ctx, nnue_stats* stats);
+NNUE_API void        nnue_reset_stats(nnue_context* ctx);
+
+/* Message of the last failed call on the context, valid until the next call */
+NNUE_API const char* nnue_last_error(nnue_context* ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef NNUE_INTERFACE_H_INCLUDED */
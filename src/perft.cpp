@@ -0,0 +1,170 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "perft.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "batch.h"
+#include "memory.h"
+
+namespace Stockfish::Benchmark {
+
+namespace {
+
+// Counts the leaves below pos, looking subtrees of depth >= 2 up in the table
+uint64_t hashed_perft(Position& pos, Depth depth, PerftTable* table) {
+
+    if (depth <= 1)
+        return depth == 1 ? MoveList<LEGAL>(pos).size() : 1;
+
+    uint64_t nodes = 0;
+
+    if (table && table->probe(pos.key(), depth, nodes))
+        return nodes;
+
+    StateInfo st;
+
+    for (const auto& m : MoveList<LEGAL>(pos))
+    {
+        pos.do_move(m, st);
+        nodes += hashed_perft(pos, depth - 1, table);
+        pos.undo_move(m);
+    }
+
+    if (table)
+        table->save(pos.key(), depth, nodes);
+
+    return nodes;
+}
+
+}
+
+
+// The data word holds the depth in its low 8 bits and the count above them.
+// Only depths >= 2 are stored, so a zero data word marks an empty entry.
+PerftTable::PerftTable(std::size_t mbSize) :
+    entryCount(mbSize * 1024 * 1024 / sizeof(Entry)) {
+
+    if (!entryCount)
+        return;
+
+    table = static_cast<Entry*>(aligned_large_pages_alloc(entryCount * sizeof(Entry)));
+
+    if (!table)
+    {
+        std::cerr << "Failed to allocate " << mbSize << "MB for perft table." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::memset(static_cast<void*>(table), 0, entryCount * sizeof(Entry));
+}
+
+
+PerftTable::~PerftTable() { aligned_large_pages_free(table); }
+
+
+bool PerftTable::probe(Key key, Depth depth, uint64_t& count) const {
+
+    if (!entryCount)
+        return false;
+
+    const Entry&   e = table[mul_hi64(key, entryCount)];
+    const uint64_t d = e.data.load(std::memory_order_relaxed);
+
+    if (!d || (d & 0xFF) != uint64_t(depth) || (e.keyXorData.load(std::memory_order_relaxed) ^ d) != key)
+        return false;
+
+    count = d >> 8;
+    return true;
+}
+
+
+void PerftTable::save(Key key, Depth depth, uint64_t count) {
+
+    if (!entryCount)
+        return;
+
+    Entry&         e = table[mul_hi64(key, entryCount)];
+    const uint64_t d = count << 8 | uint64_t(depth);
+
+    e.data.store(d, std::memory_order_relaxed);
+    e.keyXorData.store(key ^ d, std::memory_order_relaxed);
+}
+
+
+PerftResult
+parallel_perft(const std::string& input, Depth depth, bool isChess960, size_t threads, size_t hashMb) {
+
+    const TimePoint start = now();
+
+    // Checked once, before the root and every job parse it. epd_to_fen() only
+    // knows standard castling, Chess960 FENs are taken as given.
+    const std::string fen = isChess960 ? input : Batch::checked_fen(input);
+
+    StateInfo st;
+    Position  root;
+    root.set(fen, isChess960, &st);
+
+    PerftResult result;
+    for (const auto& m : MoveList<LEGAL>(root))
+        result.divide.emplace_back(m, 0);
+
+    // One job per (root move, reply) pair, so that a few heavy root moves don't
+    // leave most threads idle. Replies are picked by index in each job.
+    std::vector<std::pair<size_t, size_t>> jobs;
+    if (depth >= 2)
+        for (size_t i = 0; i < result.divide.size(); ++i)
+        {
+            StateInfo st1;
+            root.do_move(result.divide[i].first, st1);
+            for (size_t j = 0, n = MoveList<LEGAL>(root).size(); j < n; ++j)
+                jobs.emplace_back(i, j);
+            root.undo_move(result.divide[i].first);
+        }
+
+    PerftTable table(hashMb);
+    std::vector<std::atomic<uint64_t>> counts(result.divide.size());
+
+    Batch::parallel_for<1>(threads, jobs.size(), [&](size_t, size_t k) {
+        StateInfo st0, st1, st2;
+        Position  pos;
+        pos.set(fen, isChess960, &st0);
+
+        const Move m = result.divide[jobs[k].first].first;
+        pos.do_move(m, st1);
+
+        const Move reply = *(MoveList<LEGAL>(pos).begin() + jobs[k].second);
+        pos.do_move(reply, st2);
+
+        counts[jobs[k].first] += hashed_perft(pos, depth - 2, &table);
+    });
+
+    for (size_t i = 0; i < result.divide.size(); ++i)
+    {
+        result.divide[i].second = depth >= 2 ? counts[i].load() : 1;
+        result.nodes += result.divide[i].second;
+    }
+
+    result.elapsed = now() - start;
+    return result;
+}
+
+}  // namespace Stockfish::Benchmark
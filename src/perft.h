@@ -19,8 +19,14 @@
 #ifndef PERFT_H_INCLUDED
 #define PERFT_H_INCLUDED
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include "misc.h"
 #include "movegen.h"
 #include "position.h"
 #include "types.h"
@@ -62,6 +68,42 @@ inline uint64_t perft(const std::string& fen, Depth depth, bool isChess960) {
 
     return perft<true>(p, depth);
 }
+
+// PerftTable is a lock-free hash of (position key, depth) -> leaf count, shared
+// by the threads of a parallel perft. As in the EvalCache, each entry stores the
+// key xored with its data word, so a torn entry is never mistaken for a hit.
+class PerftTable {
+   public:
+    explicit PerftTable(std::size_t mbSize);
+    ~PerftTable();
+
+    PerftTable(const PerftTable&)            = delete;
+    PerftTable& operator=(const PerftTable&) = delete;
+
+    bool probe(Key key, Depth depth, uint64_t& count) const;
+    void save(Key key, Depth depth, uint64_t count);
+
+   private:
+    struct Entry {
+        std::atomic<uint64_t> keyXorData;
+        std::atomic<uint64_t> data;
+    };
+
+    Entry*      table = nullptr;
+    std::size_t entryCount;
+};
+
+struct PerftResult {
+    std::vector<std::pair<Move, uint64_t>> divide;  // Leaf count below each root move
+    uint64_t                               nodes   = 0;
+    TimePoint                              elapsed = 0;
+};
+
+// Multithreaded perft: root moves (and, for better balance, their replies) are
+// split across threads, which share an optional table of subtree counts.
+// Throws std::invalid_argument if the FEN is not well formed.
+PerftResult
+parallel_perft(const std::string& fen, Depth depth, bool isChess960, size_t threads, size_t hashMb);
 }
 
 #endif  // PERFT_H_INCLUDED
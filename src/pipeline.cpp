@@ -0,0 +1,258 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pipeline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "position.h"
+
+namespace Stockfish::Batch {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+PipelineConfig sanitize(PipelineConfig config) {
+    for (auto& t : config.threads)
+        t = std::max<std::size_t>(1, t);
+    config.queueSize = std::max<std::size_t>(1, config.queueSize);
+    return config;
+}
+
+// Jobs needed so that every queue can be full while every thread holds one,
+// evaluation threads two (the current job and the one looked ahead at)
+std::size_t pool_size(const PipelineConfig& config) {
+    return 2 * config.queueSize + config.threads[STAGE_PARSE] + 2 * config.threads[STAGE_EVALUATE]
+         + config.threads[STAGE_WRITE];
+}
+
+// Returns the nanoseconds since `mark` and moves the mark to now
+std::uint64_t lap(Clock::time_point& mark) {
+    const auto now = Clock::now();
+    const auto ns  = std::chrono::duration_cast<std::chrono::nanoseconds>(now - mark).count();
+    mark           = now;
+    return std::uint64_t(ns);
+}
+
+template<typename T>
+void push_wait(BoundedQueue<T>& queue, const T& value) {
+    while (!queue.try_push(value))
+        std::this_thread::yield();
+}
+
+// Waits for an item until the producers of the queue are all done. They push
+// before signing off, so one more attempt after that cannot miss an item.
+template<typename T>
+bool pop_wait(BoundedQueue<T>& queue, T& value, const std::atomic<std::size_t>& producers) {
+    while (!queue.try_pop(value))
+    {
+        if (producers.load(std::memory_order_acquire) == 0)
+            return queue.try_pop(value);
+
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+}
+
+
+struct Pipeline::Job {
+    std::size_t                           row;
+    StateInfo                             st;
+    Position                              pos;
+    Extract::Score                        score;
+    std::unique_ptr<Extract::Activations> act;
+};
+
+
+Pipeline::Pipeline(const Eval::NNUE::Networks& nets, EvalCache* cache, const PipelineConfig& config) :
+    networks(nets),
+    evalCache(cache),
+    cfg(sanitize(config)),
+    extractors(cfg.threads[STAGE_EVALUATE]),
+    freeJobs(pool_size(cfg)),
+    parsed(cfg.queueSize),
+    evaluated(cfg.queueSize) {
+
+    jobs.resize(pool_size(cfg));
+    for (auto& job : jobs)
+    {
+        job = std::make_unique<Job>();
+        freeJobs.try_push(job.get());
+    }
+}
+
+
+Pipeline::~Pipeline() = default;
+
+
+void Pipeline::run(const std::vector<std::string>& input, const Outputs& out) {
+
+    // The parse stage runs on its own threads, where a bad row cannot be reported
+    const std::vector<std::string> fens             = checked_fens(input);
+    const bool                     wantsActivations = out.wants_activations();
+
+    nextRow = 0;
+    for (int s = 0; s < STAGE_NB; ++s)
+        running[s] = cfg.threads[s];
+
+    std::vector<std::thread> threads;
+
+    for (std::size_t t = 0; t < cfg.threads[STAGE_PARSE]; ++t)
+        threads.emplace_back([&] { parse(fens, out); });
+
+    for (std::size_t t = 0; t < cfg.threads[STAGE_EVALUATE]; ++t)
+        threads.emplace_back([&, t] { evaluate(t, wantsActivations); });
+
+    for (std::size_t t = 0; t < cfg.threads[STAGE_WRITE]; ++t)
+        threads.emplace_back([&] { write(out); });
+
+    for (auto& th : threads)
+        th.join();
+}
+
+
+void Pipeline::parse(const std::vector<std::string>& fens, const Outputs& out) {
+
+    StageStats local;
+    auto       mark = Clock::now();
+
+    for (std::size_t row; (row = nextRow.fetch_add(1)) < fens.size();)
+    {
+        // The free list is where backpressure reaches the first stage
+        Job* job;
+        while (!freeJobs.try_pop(job))
+            std::this_thread::yield();
+        local.blockedNs += lap(mark);
+
+        job->row = row;
+        job->pos.set(fens[row], false, &job->st);
+
+        if (out.wants_planes())
+            Evaluator::store_planes(out, row, job->pos);
+
+        local.busyNs += lap(mark);
+        ++local.items;
+
+        push_wait(parsed, job);
+        local.blockedNs += lap(mark);
+    }
+
+    counters[STAGE_PARSE].items += local.items;
+    counters[STAGE_PARSE].busyNs += local.busyNs;
+    counters[STAGE_PARSE].blockedNs += local.blockedNs;
+    running[STAGE_PARSE].fetch_sub(1, std::memory_order_release);
+}
+
+
+void Pipeline::evaluate(std::size_t threadIdx, bool wantsActivations) {
+
+    // Created by the thread that uses it, like the Evaluator's extractors
+    auto& ex = extractors[threadIdx];
+    if (!ex)
+        ex = std::make_unique<Extract::Extractor>(networks, evalCache);
+
+    StageStats local;
+    auto       mark = Clock::now();
+    Job*       job;
+    Job*       next;
+
+    bool more = pop_wait(parsed, job, running[STAGE_PARSE]);
+    local.starvedNs += lap(mark);
+
+    while (more)
+    {
+        // Look one job ahead without waiting for it, and let its memory
+        // arrive while the current one is evaluated
+        if (parsed.try_pop(next))
+            ex->prefetch(next->pos);
+        else
+            next = nullptr;
+
+        if (wantsActivations && !job->act)
+            job->act = std::make_unique<Extract::Activations>();
+
+        job->score = ex->evaluate(job->pos, wantsActivations ? job->act.get() : nullptr);
+        local.busyNs += lap(mark);
+        ++local.items;
+
+        push_wait(evaluated, job);
+        local.blockedNs += lap(mark);
+
+        if (next)
+            job = next;
+        else
+        {
+            more = pop_wait(parsed, job, running[STAGE_PARSE]);
+            local.starvedNs += lap(mark);
+        }
+    }
+
+    counters[STAGE_EVALUATE].items += local.items;
+    counters[STAGE_EVALUATE].busyNs += local.busyNs;
+    counters[STAGE_EVALUATE].starvedNs += local.starvedNs;
+    counters[STAGE_EVALUATE].blockedNs += local.blockedNs;
+    running[STAGE_EVALUATE].fetch_sub(1, std::memory_order_release);
+}
+
+
+void Pipeline::write(const Outputs& out) {
+
+    const bool wantsActivations = out.wants_activations();
+
+    StageStats local;
+    auto       mark = Clock::now();
+    Job*       job;
+
+    while (pop_wait(evaluated, job, running[STAGE_EVALUATE]))
+    {
+        local.starvedNs += lap(mark);
+
+        Evaluator::store(out, job->row, job->score, wantsActivations ? job->act.get() : nullptr);
+        local.busyNs += lap(mark);
+        ++local.items;
+
+        // Cannot fail, the free list has room for every job
+        freeJobs.try_push(job);
+    }
+
+    local.starvedNs += lap(mark);
+
+    counters[STAGE_WRITE].items += local.items;
+    counters[STAGE_WRITE].busyNs += local.busyNs;
+    counters[STAGE_WRITE].starvedNs += local.starvedNs;
+    running[STAGE_WRITE].fetch_sub(1, std::memory_order_release);
+}
+
+
+StageStats Pipeline::stats(Stage s) const {
+    return {counters[s].items.load(), counters[s].busyNs.load(), counters[s].starvedNs.load(),
+            counters[s].blockedNs.load()};
+}
+
+
+void Pipeline::reset_stats() {
+    for (auto& c : counters)
+        c.items = c.busyNs = c.starvedNs = c.blockedNs = 0;
+}
+
+}  // namespace Stockfish::Batch
@@ -0,0 +1,179 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PIPELINE_H_INCLUDED
+#define PIPELINE_H_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "batch.h"
+
+namespace Stockfish::Batch {
+
+// Bounded multi-producer multi-consumer queue (D. Vyukov's design). Every cell
+// carries a sequence number saying whether it is free for the producer or full
+// for the consumer at a given position, so push and pop are a single CAS on
+// their index and never block: they fail when the queue is full or empty.
+template<typename T>
+class BoundedQueue {
+   public:
+    explicit BoundedQueue(std::size_t capacity) {
+        std::size_t size = 1;
+        while (size < capacity)
+            size *= 2;
+
+        cells = std::make_unique<Cell[]>(size);
+        mask  = size - 1;
+        for (std::size_t i = 0; i < size; ++i)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    bool try_push(const T& value) {
+        std::size_t pos = tail.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            Cell&                cell = cells[pos & mask];
+            const std::ptrdiff_t diff =
+              std::ptrdiff_t(cell.sequence.load(std::memory_order_acquire)) - std::ptrdiff_t(pos);
+
+            if (diff == 0)
+            {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    cell.value = value;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+                return false;
+            else
+                pos = tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    bool try_pop(T& value) {
+        std::size_t pos = head.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            Cell&                cell = cells[pos & mask];
+            const std::ptrdiff_t diff =
+              std::ptrdiff_t(cell.sequence.load(std::memory_order_acquire)) - std::ptrdiff_t(pos + 1);
+
+            if (diff == 0)
+            {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    value = cell.value;
+                    cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+                return false;
+            else
+                pos = head.load(std::memory_order_relaxed);
+        }
+    }
+
+   private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T                        value;
+    };
+
+    std::unique_ptr<Cell[]>               cells;
+    std::size_t                           mask;
+    alignas(64) std::atomic<std::size_t> head{0};
+    alignas(64) std::atomic<std::size_t> tail{0};
+};
+
+enum Stage {
+    STAGE_PARSE,     // FEN parsing and board planes
+    STAGE_EVALUATE,  // Features, accumulator, transform and propagation
+    STAGE_WRITE,     // Conversion into the output rows
+    STAGE_NB
+};
+
+struct PipelineConfig {
+    std::size_t threads[STAGE_NB] = {1, 1, 1};
+    std::size_t queueSize         = 256;  // Positions in flight between two stages
+};
+
+// Counters of one stage, summed over its threads and over all runs. The stage
+// with the most busy time per thread is the bottleneck.
+struct StageStats {
+    std::uint64_t items     = 0;
+    std::uint64_t busyNs    = 0;  // Doing the stage's own work
+    std::uint64_t starvedNs = 0;  // Waiting for input from the previous stage
+    std::uint64_t blockedNs = 0;  // Waiting for room downstream (backpressure)
+};
+
+// Streams positions through parse -> evaluate -> write, each stage on its own
+// group of threads, linked by bounded lock-free queues. Positions travel in
+// preallocated jobs that return to a free list once written, so memory use is
+// bounded by the queue size, and a slow stage throttles the ones before it.
+// Evaluation threads look one job ahead and prefetch its cache entry and
+// feature weights while evaluating the current one.
+//
+// Rows are written as by Evaluator::evaluate() without deduplication,
+// tablebases, mirroring or sparse features.
+class Pipeline {
+   public:
+    Pipeline(const Eval::NNUE::Networks& networks, EvalCache* cache, const PipelineConfig& config);
+    ~Pipeline();
+
+    // Throws std::invalid_argument, writing nothing, if a FEN is not well formed
+    void run(const std::vector<std::string>& fens, const Outputs& out);
+
+    const PipelineConfig& config() const { return cfg; }
+    StageStats            stats(Stage s) const;
+    void                  reset_stats();
+
+   private:
+    struct Job;
+
+    struct Counters {
+        std::atomic<std::uint64_t> items{0}, busyNs{0}, starvedNs{0}, blockedNs{0};
+    };
+
+    void parse(const std::vector<std::string>& fens, const Outputs& out);
+    void evaluate(std::size_t threadIdx, bool wantsActivations);
+    void write(const Outputs& out);
+
+    const Eval::NNUE::Networks&                      networks;
+    EvalCache*                                       evalCache;
+    PipelineConfig                                   cfg;
+    std::vector<std::unique_ptr<Job>>                jobs;
+    std::vector<std::unique_ptr<Extract::Extractor>> extractors;
+    BoundedQueue<Job*>                               freeJobs, parsed, evaluated;
+    std::atomic<std::size_t>                         nextRow{0};
+    std::atomic<std::size_t>                         running[STAGE_NB];
+    Counters                                         counters[STAGE_NB];
+};
+
+}  // namespace Stockfish::Batch
+
+#endif  // #ifndef PIPELINE_H_INCLUDED
@@ -0,0 +1,96 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "planes.h"
+
+#include <algorithm>
+
+#include "bitboard.h"
+#include "position.h"
+
+namespace Stockfish::Planes {
+
+namespace {
+
+// The plane that holds plane p after swapping colours
+constexpr int swap_colors(int p) {
+    return p < PLANE_ATTACKS ? (p + 6) % 12 : p < PLANE_CHECKERS ? p ^ 1 : p;
+}
+
+Bitboard flip_ranks(Bitboard b) {
+    Bitboard r = 0;
+    for (int rank = 0; rank < 8; ++rank)
+        r |= ((b >> (8 * rank)) & 0xFF) << (8 * (7 - rank));
+    return r;
+}
+
+}
+
+
+void encode(const Position& pos, Bitboard planes[PLANE_NB]) {
+
+    for (Color c : {WHITE, BLACK})
+    {
+        for (PieceType pt = PAWN; pt <= KING; ++pt)
+            planes[PLANE_PIECES + 6 * c + pt - PAWN] = pos.pieces(c, pt);
+
+        planes[PLANE_ATTACKS + c] = pos.attacks_by<PAWN>(c) | pos.attacks_by<KNIGHT>(c)
+                                  | pos.attacks_by<BISHOP>(c) | pos.attacks_by<ROOK>(c)
+                                  | pos.attacks_by<QUEEN>(c) | pos.attacks_by<KING>(c);
+
+        // Blockers of a king include the pieces of the other side that shield
+        // it from discovered attacks, only our own ones are pinned.
+        planes[PLANE_PINNED + c] = pos.blockers_for_king(c) & pos.pieces(c);
+    }
+
+    planes[PLANE_CHECKERS] = pos.checkers();
+}
+
+
+void unpack(const Bitboard planes[PLANE_NB], std::uint8_t* out) {
+
+    for (int p = 0; p < PLANE_NB; ++p, out += SQUARE_NB)
+        for (Square s = SQ_A1; s <= SQ_H8; ++s)
+            out[s] = (planes[p] >> s) & 1;
+}
+
+
+
+void flip(Bitboard planes[PLANE_NB]) {
+
+    Bitboard flipped[PLANE_NB];
+
+    for (int p = 0; p < PLANE_NB; ++p)
+        flipped[swap_colors(p)] = flip_ranks(planes[p]);
+
+    std::copy(flipped, flipped + PLANE_NB, planes);
+}
+
+
+void flip(std::uint8_t* planes) {
+
+    std::uint8_t flipped[PLANE_NB * SQUARE_NB];
+
+    for (int p = 0; p < PLANE_NB; ++p)
+        for (Square s = SQ_A1; s <= SQ_H8; ++s)
+            flipped[swap_colors(p) * SQUARE_NB + flip_rank(s)] = planes[p * SQUARE_NB + s];
+
+    std::copy(flipped, flipped + PLANE_NB * SQUARE_NB, planes);
+}
+
+}  // namespace Stockfish::Planes
@@ -0,0 +1,59 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PLANES_H_INCLUDED
+#define PLANES_H_INCLUDED
+
+#include <cstdint>
+
+#include "types.h"
+
+namespace Stockfish {
+
+class Position;
+
+namespace Planes {
+
+// Board planes of a position, each one a bitboard over the 64 squares (bit s is
+// square s, a1 = 0, h8 = 63). Colours are absolute, not relative to the side to move.
+enum Plane {
+    PLANE_PIECES   = 0,   // 12 planes: white pawn .. king, then black pawn .. king
+    PLANE_ATTACKS  = 12,  // 2 planes: squares attacked by white, by black
+    PLANE_PINNED   = 14,  // 2 planes: white, black pieces pinned to their own king
+    PLANE_CHECKERS = 16,  // Pieces giving check to the side to move
+    PLANE_NB       = 17
+};
+
+void encode(const Position& pos, Bitboard planes[PLANE_NB]);
+
+// Turns the planes of a position into those of its colour-flipped twin (colours
+// swapped, board mirrored top to bottom), as encode() would return them after
+// Position::flip().
+void flip(Bitboard planes[PLANE_NB]);
+
+// Same for planes unpacked to one byte per square
+void flip(std::uint8_t* planes);
+
+// Writes the planes one byte per square, as a [PLANE_NB][SQUARE_NB] array of 0/1
+void unpack(const Bitboard planes[PLANE_NB], std::uint8_t* out);
+
+}  // namespace Planes
+
+}  // namespace Stockfish
+
+#endif  // #ifndef PLANES_H_INCLUDED
@@ -1363,4 +1363,100 @@ bool Position::pos_is_ok() const {
     return true;
 }
 
+// FEN of a FEN or EPD line: the four position fields, then the move counters
+// if the line has them, else "0 1". Empty if the position fields are not well
+// formed (ranks of 8 squares, one king per side, at most 32 pieces, no pawn on
+// the first or last rank, castling rights in KQkq form, an en passant square or
+// "-"). As in Batch::Protocol::unpack_fen(), castling rights without the king
+// and the rook on their initial squares, and an en passant square on the wrong
+// rank, are dropped. Position::set() expects such a FEN and does not check it.
+string epd_to_fen(const string& line) {
+
+    std::istringstream ss(line);
+    string             fields[6];
+
+    for (int i = 0; i < 4; ++i)
+        if (!(ss >> fields[i]))
+            return {};
+
+    if (fields[1] != "w" && fields[1] != "b")
+        return {};
+
+    char board[SQUARE_NB] = {};
+    int  rank = RANK_8, file = FILE_A, kings[COLOR_NB] = {}, count = 0;
+
+    for (char c : fields[0])
+    {
+        if (c == '/')
+        {
+            if (file != FILE_NB || rank == RANK_1)
+                return {};
+            --rank;
+            file = FILE_A;
+        }
+        else if (c >= '1' && c <= '8')
+        {
+            if ((file += c - '0') > FILE_NB)
+                return {};
+        }
+        else if (std::string_view("PNBRQKpnbrqk").find(c) != std::string_view::npos)
+        {
+            if (file == FILE_NB || ++count > 32
+                || ((c == 'P' || c == 'p') && (rank == RANK_1 || rank == RANK_8)))
+                return {};
+            board[make_square(File(file++), Rank(rank))] = c;
+            kings[WHITE] += c == 'K';
+            kings[BLACK] += c == 'k';
+        }
+        else
+            return {};
+    }
+
+    if (rank != RANK_1 || file != FILE_NB || kings[WHITE] != 1 || kings[BLACK] != 1)
+        return {};
+
+    // Only standard castling, with the king and the rook on their initial squares
+    string castling;
+    if (fields[2] != "-")
+    {
+        for (char c : fields[2])
+            if (std::string_view("KQkq").find(c) == std::string_view::npos)
+                return {};
+
+        auto keep = [&](char right, Square king, Square rook) {
+            const bool white = right == 'K' || right == 'Q';
+            if (fields[2].find(right) != string::npos && board[king] == (white ? 'K' : 'k')
+                && board[rook] == (white ? 'R' : 'r'))
+                castling += right;
+        };
+
+        keep('K', SQ_E1, SQ_H1);
+        keep('Q', SQ_E1, SQ_A1);
+        keep('k', SQ_E8, SQ_H8);
+        keep('q', SQ_E8, SQ_A8);
+    }
+
+    // Position::set() keeps the en passant square only if a capture is possible
+    string ep = "-";
+    if (fields[3] != "-")
+    {
+        if (fields[3].size() != 2 || fields[3][0] < 'a' || fields[3][0] > 'h')
+            return {};
+
+        if (fields[3][1] == (fields[1] == "w" ? '6' : '3'))
+            ep = fields[3];
+        else if (fields[3][1] < '1' || fields[3][1] > '8')
+            return {};
+    }
+
+    // EPD operations follow the position fields instead of the counters
+    auto is_number = [](const string& str) {
+        return std::all_of(str.begin(), str.end(), [](char c) { return c >= '0' && c <= '9'; });
+    };
+    const bool counters = ss >> fields[4] >> fields[5] && is_number(fields[4]) && is_number(fields[5]);
+
+    return fields[0] + " " + fields[1] + " " + (castling.empty() ? "-" : castling) + " " + ep
+         + (counters ? " " + fields[4] + " " + fields[5] : " 0 1");
+}
+
 }  // namespace Stockfish
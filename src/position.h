@@ -201,6 +201,9 @@ class Position {
 
 std::ostream& operator<<(std::ostream& os, const Position& pos);
 
+// Well-formed FEN of a FEN or EPD line, or an empty string, see position.cpp
+std::string epd_to_fen(const std::string& line);
+
 inline Color Position::side_to_move() const { return sideToMove; }
 
 inline Piece Position::piece_on(Square s) const {
@@ -116,7 +116,7 @@ struct LimitsType {
     LimitsType() {
         time[WHITE] = time[BLACK] = inc[WHITE] = inc[BLACK] = npmsec = movetime = TimePoint(0);
         movestogo = depth = mate = perft = infinite = 0;
-        nodes                                       = 0;
+        nodes = multiPV                             = 0;
         ponderMode                                  = false;
     }
 
@@ -126,6 +126,7 @@ struct LimitsType {
     TimePoint                time[COLOR_NB], inc[COLOR_NB], npmsec, movetime, startTime;
     int                      movestogo, depth, mate, perft, infinite;
     uint64_t                 nodes;
+    size_t                   multiPV;  // Overrides the MultiPV option if not 0
     bool                     ponderMode;
 };
 
@@ -170,6 +171,7 @@ struct InfoFull: InfoShort {
     std::string_view bound;
     size_t           timeMs;
     size_t           nodes;
+    size_t           moveNodes;  // Searched under the first move of the line
     size_t           nps;
     size_t           tbHits;
     std::string_view pv;
@@ -294,7 +296,8 @@ class Worker {
     TTMoveHistory ttMoveHistory;
 
    private:
-    void iterative_deepening();
+    void   iterative_deepening();
+    size_t multi_pv() const;
 
     void do_move(Position& pos, const Move move, StateInfo& st, Stack* const ss);
     void
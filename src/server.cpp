@@ -0,0 +1,679 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "server.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <utility>
+
+#include "bitboard.h"
+#include "position.h"
+
+#if !defined(_WIN32)
+    #include <cerrno>
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#endif
+
+namespace Stockfish::Batch {
+
+namespace Protocol {
+
+PackedPosition pack(const Position& pos) {
+
+    PackedPosition p{};
+    p.occupied = pos.pieces();
+
+    int n = 0;
+    for (Bitboard b = pos.pieces(); b; ++n)
+        p.pieces[n / 2] |= std::uint8_t(pos.piece_on(pop_lsb(b)) << (n % 2 * 4));
+
+    for (CastlingRights cr : {WHITE_OO, WHITE_OOO, BLACK_OO, BLACK_OOO})
+        if (pos.can_castle(cr))
+            p.castling |= cr;
+
+    p.sideToMove = std::uint8_t(pos.side_to_move());
+    p.epSquare   = std::uint8_t(pos.ep_square());
+    p.rule50     = std::uint8_t(std::min(pos.rule50_count(), 255));
+    p.fullmove   = std::uint16_t(1 + (pos.game_ply() - (pos.side_to_move() == BLACK)) / 2);
+    return p;
+}
+
+
+std::string unpack_fen(const PackedPosition& p) {
+
+    constexpr const char* PieceChars = " PNBRQK  pnbrqk";
+
+    if (popcount(p.occupied) > 32 || p.sideToMove > BLACK)
+        return std::string();
+
+    Piece board[SQUARE_NB] = {};
+    int   kings[COLOR_NB]  = {};
+    int   n                = 0;
+
+    for (Bitboard b = p.occupied; b; ++n)
+    {
+        const Square s  = pop_lsb(b);
+        const Piece  pc = Piece((p.pieces[n / 2] >> (n % 2 * 4)) & 15);
+
+        if (type_of(pc) == NO_PIECE_TYPE || type_of(pc) > KING)
+            return std::string();
+
+        if (type_of(pc) == PAWN && (rank_of(s) == RANK_1 || rank_of(s) == RANK_8))
+            return std::string();
+
+        kings[color_of(pc)] += type_of(pc) == KING;
+        board[s] = pc;
+    }
+
+    if (kings[WHITE] != 1 || kings[BLACK] != 1)
+        return std::string();
+
+    std::string fen;
+    for (Rank r = RANK_8; r >= RANK_1; --r)
+    {
+        int empty = 0;
+        for (File f = FILE_A; f <= FILE_H; ++f)
+        {
+            const Piece pc = board[make_square(f, r)];
+            if (pc == NO_PIECE)
+                ++empty;
+            else
+            {
+                if (empty)
+                    fen += char('0' + empty);
+                fen += PieceChars[pc];
+                empty = 0;
+            }
+        }
+        if (empty)
+            fen += char('0' + empty);
+        if (r > RANK_1)
+            fen += '/';
+    }
+
+    fen += p.sideToMove == WHITE ? " w " : " b ";
+
+    // Only standard castling, with the king and the rook on their initial squares
+    const std::size_t castlingStart = fen.size();
+    if ((p.castling & WHITE_OO) && board[SQ_E1] == W_KING && board[SQ_H1] == W_ROOK)
+        fen += 'K';
+    if ((p.castling & WHITE_OOO) && board[SQ_E1] == W_KING && board[SQ_A1] == W_ROOK)
+        fen += 'Q';
+    if ((p.castling & BLACK_OO) && board[SQ_E8] == B_KING && board[SQ_H8] == B_ROOK)
+        fen += 'k';
+    if ((p.castling & BLACK_OOO) && board[SQ_E8] == B_KING && board[SQ_A8] == B_ROOK)
+        fen += 'q';
+    if (fen.size() == castlingStart)
+        fen += '-';
+
+    // Position::set() keeps the en passant square only if a capture is possible
+    const Square ep = Square(p.epSquare);
+    if (is_ok(ep) && rank_of(ep) == (p.sideToMove == WHITE ? RANK_6 : RANK_3))
+    {
+        fen += ' ';
+        fen += char('a' + file_of(ep));
+        fen += char('1' + rank_of(ep));
+    }
+    else
+        fen += " -";
+
+    fen += ' ' + std::to_string(p.rule50) + ' ' + std::to_string(std::max<int>(1, p.fullmove));
+    return fen;
+}
+
+}  // namespace Protocol
+
+
+using namespace Protocol;
+
+#if !defined(_WIN32)
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+bool read_all(int fd, void* data, std::size_t size) {
+    auto* p = static_cast<char*>(data);
+    while (size)
+    {
+        const ssize_t r = ::recv(fd, p, size, 0);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            return false;
+        p += r;
+        size -= std::size_t(r);
+    }
+    return true;
+}
+
+bool write_all(int fd, const void* data, std::size_t size) {
+
+    #if defined(MSG_NOSIGNAL)
+    constexpr int Flags = MSG_NOSIGNAL;
+    #else
+    constexpr int Flags = 0;  // SO_NOSIGPIPE is set on the socket instead
+    #endif
+
+    auto* p = static_cast<const char*>(data);
+    while (size)
+    {
+        const ssize_t r = ::send(fd, p, size, Flags);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            return false;
+        p += r;
+        size -= std::size_t(r);
+    }
+    return true;
+}
+
+void no_sigpipe([[maybe_unused]] int fd) {
+    #if defined(SO_NOSIGPIPE)
+    int one = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+    #endif
+}
+
+bool make_address(const std::string& path, sockaddr_un& addr) {
+    addr            = {};
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path))
+        return false;
+    std::memcpy(addr.sun_path, path.data(), path.size());
+    return true;
+}
+
+std::vector<char> make_response(std::uint32_t id, std::uint32_t count, Status status, std::size_t body) {
+    std::vector<char> msg(sizeof(FrameHeader) + body);
+    const FrameHeader h{Magic, id, count, status};
+    std::memcpy(msg.data(), &h, sizeof(h));
+    return msg;
+}
+
+}
+
+
+struct Server::Connection {
+    int                           fd;
+    std::thread                   reader, writer;
+    std::mutex                    mutex;
+    std::condition_variable       cv;
+    std::deque<std::vector<char>> outbox;
+    std::size_t                   inFlight = 0;      // Read and not yet sent
+    bool                          closing  = false;  // The reader is done
+    bool                          broken   = false;  // A send failed
+    std::atomic<bool>             done{false};       // The reader can be joined
+
+    // Queues a response. The notification is sent under the lock, as the
+    // connection may be gone as soon as the writer sees the last response.
+    void post(std::vector<char> msg) {
+        std::lock_guard<std::mutex> lk(mutex);
+        outbox.push_back(std::move(msg));
+        cv.notify_all();
+    }
+};
+
+
+Server::Server(const Eval::NNUE::Networks& networks, EvalCache* cache, const ServerConfig& config) :
+    cfg(config),
+    dispatcher(networks, cache, config.threads, config.maxBatch, config.maxDelayUs) {
+    cfg.maxInFlight = std::max<std::size_t>(1, cfg.maxInFlight);
+}
+
+
+Server::~Server() { stop(); }
+
+
+bool Server::start(const std::string& path) {
+
+    if (listenFd >= 0)
+    {
+        lastError = "the server is already running";
+        return false;
+    }
+
+    sockaddr_un addr;
+    if (!make_address(path, addr))
+    {
+        lastError = "invalid socket path: " + path;
+        return false;
+    }
+
+    // Only replace a stale socket left behind by an earlier server, never a
+    // regular file or directory that happens to live at the path
+    struct stat st;
+    if (::lstat(path.c_str(), &st) == 0)
+    {
+        if (!S_ISSOCK(st.st_mode))
+        {
+            lastError = path + ": exists and is not a socket";
+            return false;
+        }
+        if (::unlink(path.c_str()) < 0)
+        {
+            lastError = path + ": " + std::strerror(errno);
+            return false;
+        }
+    }
+    else if (errno != ENOENT)
+    {
+        lastError = path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0)
+    {
+        lastError = std::string("socket: ") + std::strerror(errno);
+        return false;
+    }
+
+    if (::bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0
+        || ::listen(listenFd, 64) < 0)
+    {
+        lastError = path + ": " + std::strerror(errno);
+        ::close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+
+    socketPath = path;
+    stopping   = false;
+    acceptThread = std::thread(&Server::accept_loop, this);
+    return true;
+}
+
+
+void Server::stop() {
+
+    if (listenFd < 0)
+        return;
+
+    stopping = true;
+    acceptThread.join();
+    ::close(listenFd);
+    listenFd = -1;
+    ::unlink(socketPath.c_str());
+
+    // Readers see end of file, then wait for their requests to be answered
+    {
+        std::lock_guard<std::mutex> lk(connectionsMutex);
+        for (auto& c : connectionList)
+            ::shutdown(c->fd, SHUT_RD);
+    }
+    reap(true);
+}
+
+
+std::size_t Server::connections() const {
+    std::lock_guard<std::mutex> lk(connectionsMutex);
+    return std::size_t(std::count_if(connectionList.begin(), connectionList.end(),
+                                     [](const auto& c) { return !c->done; }));
+}
+
+
+void Server::accept_loop() {
+
+    while (!stopping)
+    {
+        // Poll with a timeout so that stop() does not depend on close() waking accept()
+        pollfd pfd{listenFd, POLLIN, 0};
+        if (::poll(&pfd, 1, 100) <= 0)
+        {
+            reap(false);
+            continue;
+        }
+
+        const int fd = ::accept(listenFd, nullptr, nullptr);
+        if (fd < 0)
+            continue;
+
+        no_sigpipe(fd);
+
+        auto  c    = std::make_unique<Connection>();
+        auto& conn = *c;
+        conn.fd    = fd;
+
+        {
+            std::lock_guard<std::mutex> lk(connectionsMutex);
+            connectionList.push_back(std::move(c));
+        }
+
+        conn.reader = std::thread(&Server::read_loop, this, std::ref(conn));
+        reap(false);
+    }
+}
+
+
+void Server::reap(bool all) {
+
+    std::list<std::unique_ptr<Connection>> finished;
+    {
+        std::lock_guard<std::mutex> lk(connectionsMutex);
+        for (auto it = connectionList.begin(); it != connectionList.end();)
+        {
+            auto next = std::next(it);
+            if (all || (*it)->done)
+                finished.splice(finished.end(), connectionList, it);
+            it = next;
+        }
+    }
+
+    for (auto& c : finished)
+        if (c->reader.joinable())
+            c->reader.join();
+}
+
+
+void Server::read_loop(Connection& c) {
+
+    c.writer = std::thread(&Server::write_loop, this, std::ref(c));
+
+    std::vector<PackedPosition> packed;
+    FrameHeader                 h;
+
+    while (read_all(c.fd, &h, sizeof(h)))
+    {
+        if (h.magic != Magic || h.count > MaxPositions)
+        {
+            std::lock_guard<std::mutex> lk(c.mutex);
+            ++c.inFlight;
+            c.outbox.push_back(make_response(h.id, 0, STATUS_BAD_FRAME, 0));
+            c.cv.notify_all();
+            break;
+        }
+
+        packed.resize(h.count);
+        if (!read_all(c.fd, packed.data(), h.count * sizeof(PackedPosition)))
+            break;
+
+        std::vector<std::string> fens(h.count);
+        bool                     valid = true;
+        for (std::size_t i = 0; i < h.count && valid; ++i)
+            valid = !(fens[i] = unpack_fen(packed[i])).empty();
+
+        // Backpressure: stop reading until the window has room
+        {
+            std::unique_lock<std::mutex> lk(c.mutex);
+            c.cv.wait(lk, [&] { return c.broken || c.inFlight < cfg.maxInFlight; });
+            if (c.broken)
+                break;
+            ++c.inFlight;
+        }
+
+        if (!valid || fens.empty())
+        {
+            c.post(make_response(h.id, 0, valid ? STATUS_OK : STATUS_BAD_POSITION, 0));
+            continue;
+        }
+
+        const bool activations = h.flags & REQUEST_ACTIVATIONS;
+        const auto id          = h.id;
+
+        dispatcher.submit(std::move(fens), activations,
+                          [&c, id, activations](const Outputs& out, std::size_t first, std::size_t count) {
+                              const std::size_t body =
+                                count * (sizeof(EvalRecord) + (activations ? ActivationFloats * sizeof(float) : 0));
+
+                              auto  msg = make_response(id, std::uint32_t(count), STATUS_OK, body);
+                              char* p   = msg.data() + sizeof(FrameHeader);
+
+                              for (std::size_t i = first; i < first + count; ++i)
+                              {
+                                  const EvalRecord r{out.final[i], out.psqt[i], out.positional[i], out.smallNet[i], {}};
+                                  std::memcpy(p, &r, sizeof(r));
+                                  p += sizeof(r);
+                              }
+
+                              auto put = [&](const float* src, std::size_t width, std::size_t i) {
+                                  std::memcpy(p, src + i * width, width * sizeof(float));
+                                  p += width * sizeof(float);
+                              };
+
+                              if (activations)
+                                  for (std::size_t i = first; i < first + count; ++i)
+                                  {
+                                      put(out.accumulation, COLOR_NB * Extract::MaxDimensions, i);
+                                      put(out.psqtAccumulation, COLOR_NB * Eval::NNUE::PSQTBuckets, i);
+                                      put(out.layer1, Extract::Layer1Size, i);
+                                      put(out.layer2, Extract::Layer2Size, i);
+                                  }
+
+                              c.post(std::move(msg));
+                          });
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(c.mutex);
+        c.closing = true;
+        c.cv.notify_all();
+    }
+
+    c.writer.join();
+    ::close(c.fd);
+    c.done = true;
+}
+
+
+void Server::write_loop(Connection& c) {
+
+    for (;;)
+    {
+        std::vector<char> msg;
+        {
+            std::unique_lock<std::mutex> lk(c.mutex);
+            c.cv.wait(lk, [&] { return !c.outbox.empty() || (c.closing && c.inFlight == 0); });
+
+            if (c.outbox.empty())
+                return;
+
+            msg = std::move(c.outbox.front());
+            c.outbox.pop_front();
+        }
+
+        // After a failed send the remaining responses are dropped, but still
+        // waited for, as their completions refer to the connection
+        const bool sent = !c.broken && write_all(c.fd, msg.data(), msg.size());
+
+        std::lock_guard<std::mutex> lk(c.mutex);
+        if (!sent && !c.broken)
+        {
+            c.broken = true;
+            ::shutdown(c.fd, SHUT_RDWR);
+        }
+        --c.inFlight;
+        c.cv.notify_all();
+    }
+}
+
+
+ClientStats run_client(const std::string& path, const std::vector<std::string>& fens, const ClientConfig& config) {
+
+    ClientStats stats;
+
+    sockaddr_un addr;
+    if (fens.empty() || !make_address(path, addr))
+    {
+        stats.error = fens.empty() ? "no positions" : "invalid socket path: " + path;
+        return stats;
+    }
+
+    const std::vector<std::string> checked = checked_fens(fens);
+    std::vector<PackedPosition>    packed(checked.size());
+    for (std::size_t i = 0; i < checked.size(); ++i)
+    {
+        StateInfo st;
+        Position  pos;
+        pos.set(checked[i], false, &st);
+        packed[i] = pack(pos);
+    }
+
+    const std::size_t connections = std::max<std::size_t>(1, config.connections);
+    const std::size_t window      = std::max<std::size_t>(1, config.pipeline);
+    const std::size_t perRequest  = std::clamp<std::size_t>(config.positions, 1, MaxPositions);
+    const std::size_t recordSize =
+      sizeof(EvalRecord) + (config.activations ? ActivationFloats * sizeof(float) : 0);
+
+    std::mutex statsMutex;
+
+    auto client = [&](std::size_t idx) {
+        const std::size_t requests = config.requests / connections + (idx < config.requests % connections);
+
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || ::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0)
+        {
+            std::lock_guard<std::mutex> lk(statsMutex);
+            stats.error = path + ": " + std::strerror(errno);
+            if (fd >= 0)
+                ::close(fd);
+            return;
+        }
+        no_sigpipe(fd);
+
+        std::mutex                     mutex;
+        std::condition_variable        cv;
+        std::size_t                    inFlight = 0;
+        bool                           failed   = false;
+        std::vector<Clock::time_point> sent(requests);
+
+        // The sender keeps `window` requests in flight, the receiver frees the slots
+        std::thread sender([&] {
+            std::vector<char> msg(sizeof(FrameHeader) + perRequest * sizeof(PackedPosition));
+
+            for (std::size_t r = 0; r < requests; ++r)
+            {
+                {
+                    std::unique_lock<std::mutex> lk(mutex);
+                    cv.wait(lk, [&] { return failed || inFlight < window; });
+                    if (failed)
+                        return;
+                    ++inFlight;
+                    sent[r] = Clock::now();
+                }
+
+                const FrameHeader h{Magic, std::uint32_t(r), std::uint32_t(perRequest),
+                                    config.activations ? std::uint32_t(REQUEST_ACTIVATIONS) : 0};
+                std::memcpy(msg.data(), &h, sizeof(h));
+                for (std::size_t i = 0; i < perRequest; ++i)
+                    std::memcpy(msg.data() + sizeof(h) + i * sizeof(PackedPosition),
+                                &packed[(idx + r * perRequest + i) % packed.size()], sizeof(PackedPosition));
+
+                if (!write_all(fd, msg.data(), msg.size()))
+                    return;
+            }
+        });
+
+        Histogram         latency;
+        std::size_t       positions = 0, errors = 0, received = 0;
+        std::vector<char> body;
+        FrameHeader       h;
+
+        for (; received < requests; ++received)
+        {
+            if (!read_all(fd, &h, sizeof(h)) || h.magic != Magic || h.id >= requests)
+                break;
+
+            body.resize(h.count * recordSize);
+            if (!read_all(fd, body.data(), body.size()))
+                break;
+
+            std::lock_guard<std::mutex> lk(mutex);
+            latency.add(std::uint64_t(
+              std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - sent[h.id]).count()));
+            positions += h.count;
+            errors += h.flags != STATUS_OK;
+            --inFlight;
+            cv.notify_one();
+        }
+
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            failed = true;
+            cv.notify_one();
+        }
+        ::shutdown(fd, SHUT_RDWR);
+        sender.join();
+        ::close(fd);
+
+        std::lock_guard<std::mutex> lk(statsMutex);
+        if (received < requests && stats.error.empty())
+            stats.error = "connection closed by the server";
+        stats.requests += received;
+        stats.positions += positions;
+        stats.errors += errors;
+        stats.latencyUs.merge(latency);
+    };
+
+    const auto start = Clock::now();
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < connections; ++i)
+        threads.emplace_back(client, i);
+    for (auto& th : threads)
+        th.join();
+
+    stats.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return stats;
+}
+
+#else
+
+struct Server::Connection {
+    std::thread reader;
+    bool        done = true;
+};
+
+Server::Server(const Eval::NNUE::Networks& networks, EvalCache* cache, const ServerConfig& config) :
+    cfg(config),
+    dispatcher(networks, cache, config.threads, config.maxBatch, config.maxDelayUs) {}
+
+Server::~Server() = default;
+
+bool Server::start(const std::string&) {
+    lastError = "Unix domain sockets are not supported on this platform";
+    return false;
+}
+
+void Server::stop() {}
+
+std::size_t Server::connections() const { return 0; }
+
+void Server::accept_loop() {}
+void Server::read_loop(Connection&) {}
+void Server::write_loop(Connection&) {}
+void Server::reap(bool) {}
+
+ClientStats run_client(const std::string&, const std::vector<std::string>&, const ClientConfig&) {
+    ClientStats stats;
+    stats.error = "Unix domain sockets are not supported on this platform";
+    return stats;
+}
+
+#endif
+
+}  // namespace Stockfish::Batch
@@ -0,0 +1,187 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SERVER_H_INCLUDED
+#define SERVER_H_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dispatcher.h"
+
+namespace Stockfish {
+
+class Position;
+
+namespace Batch {
+
+// Binary protocol of the evaluation server. A client sends request frames and
+// the server answers each one with a response frame carrying the same id.
+// Requests may be pipelined: the server keeps reading while earlier requests
+// are evaluated, so a client that pipelines must read responses while it
+// sends. Responses are matched by id. Fields are in native byte order, which
+// is little-endian on every supported target.
+//
+//   request:  FrameHeader {Magic, id, count, flags}, count x PackedPosition
+//   response: FrameHeader {Magic, id, count, status}, count x EvalRecord, then
+//             with REQUEST_ACTIVATIONS count x ActivationFloats floats
+namespace Protocol {
+
+constexpr std::uint32_t Magic        = 0x45554E4E;  // "NNUE"
+constexpr std::uint32_t MaxPositions = 1 << 16;     // Per request
+
+enum Flags : std::uint32_t {
+    REQUEST_ACTIVATIONS = 1
+};
+
+enum Status : std::uint32_t {
+    STATUS_OK,
+    STATUS_BAD_POSITION,  // Nothing was evaluated (count is 0), the connection stays open
+    STATUS_BAD_FRAME      // Wrong magic or too many positions, the connection is closed
+};
+
+struct FrameHeader {
+    std::uint32_t magic;
+    std::uint32_t id;
+    std::uint32_t count;
+    std::uint32_t flags;  // Status in responses
+};
+
+// A position in 32 bytes: the occupied squares (bit s is square s, a1 = 0),
+// then the Piece on each of them in square order, 4 bits each, low nibble
+// first. castling holds CastlingRights bits, epSquare is SQ_NONE if unset.
+struct PackedPosition {
+    std::uint64_t occupied;
+    std::uint8_t  pieces[16];
+    std::uint8_t  sideToMove;
+    std::uint8_t  castling;
+    std::uint8_t  epSquare;
+    std::uint8_t  rule50;
+    std::uint16_t fullmove;
+    std::uint8_t  reserved[2];
+};
+
+struct EvalRecord {
+    float        final, psqt, positional;  // Same scale as Outputs
+    std::uint8_t smallNet;
+    std::uint8_t reserved[3];
+};
+
+// Floats of the activations of one position: accumulation [COLOR_NB][MaxDimensions],
+// PSQT accumulation [COLOR_NB][PSQTBuckets], layer 1 and layer 2
+constexpr std::size_t ActivationFloats = COLOR_NB * Extract::MaxDimensions
+                                       + COLOR_NB * Eval::NNUE::PSQTBuckets
+                                       + Extract::Layer1Size + Extract::Layer2Size;
+
+static_assert(sizeof(FrameHeader) == 16, "FrameHeader must be packed");
+static_assert(sizeof(PackedPosition) == 32, "PackedPosition must be packed");
+static_assert(sizeof(EvalRecord) == 16, "EvalRecord must be packed");
+
+PackedPosition pack(const Position& pos);
+
+// FEN of a packed position, or an empty string if it cannot be one (bad piece
+// codes, not one king per side, pawns on the first or last rank). Castling
+// rights without their king and rook on the initial squares are dropped.
+std::string unpack_fen(const PackedPosition& packed);
+
+}  // namespace Protocol
+
+struct ServerConfig {
+    std::size_t   threads     = 1;
+    std::size_t   maxBatch    = 1024;
+    std::uint64_t maxDelayUs  = 0;
+    std::size_t   maxInFlight = 64;  // Requests per connection not yet answered
+};
+
+// Serves the protocol above on a Unix domain socket. Every connection has a
+// reader thread, which decodes requests and submits them to a shared
+// Dispatcher, and a writer thread, which sends the responses its completions
+// queue. Requests of all connections are batched together. A connection with
+// maxInFlight unanswered requests is not read from until some are sent.
+class Server {
+   public:
+    Server(const Eval::NNUE::Networks& networks, EvalCache* cache, const ServerConfig& config);
+    ~Server();
+
+    // Listens at path, replacing a stale socket file, and serves connections
+    // on background threads. Returns false with error() set on failure,
+    // including when something other than a socket already exists at path.
+    bool start(const std::string& path);
+
+    // Stops accepting and reading, answers the requests already read, then
+    // closes the connections and removes the socket file
+    void stop();
+
+    const std::string& error() const { return lastError; }
+    std::size_t        connections() const;
+    DispatcherStats    stats() const { return dispatcher.stats(); }
+    void               reset_stats() { dispatcher.reset_stats(); }
+
+   private:
+    struct Connection;
+
+    void accept_loop();
+    void read_loop(Connection& c);
+    void write_loop(Connection& c);
+    void reap(bool all);
+
+    ServerConfig                            cfg;
+    Dispatcher                              dispatcher;
+    std::string                             socketPath, lastError;
+    int                                     listenFd = -1;
+    std::atomic<bool>                       stopping{false};
+    std::thread                             acceptThread;
+    mutable std::mutex                      connectionsMutex;
+    std::list<std::unique_ptr<Connection>> connectionList;
+};
+
+struct ClientConfig {
+    std::size_t connections = 4;
+    std::size_t pipeline    = 8;  // Requests in flight per connection
+    std::size_t positions   = 1;  // Per request
+    std::size_t requests    = 10000;
+    bool        activations = false;
+};
+
+struct ClientStats {
+    std::size_t requests  = 0;
+    std::size_t positions = 0;
+    std::size_t errors    = 0;  // Responses with a status other than STATUS_OK
+    double      seconds   = 0;
+    Histogram   latencyUs;  // Round trip of a request
+    std::string error;      // Set if a connection failed
+};
+
+// Loopback load generator for a Server: sends `requests` requests built from
+// `fens` round robin, spread over the connections, each keeping `pipeline`
+// requests in flight, and measures throughput and round trip latencies. Throws
+// std::invalid_argument if a FEN is not well formed.
+ClientStats run_client(const std::string& path, const std::vector<std::string>& fens, const ClientConfig& config);
+
+}  // namespace Batch
+
+}  // namespace Stockfish
+
+#endif  // #ifndef SERVER_H_INCLUDED
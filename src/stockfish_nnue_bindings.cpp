@@ -7,17 +7,43 @@
 #include <pybind11/numpy.h>
 #include <pybind11/stl.h>
 
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
 #include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "position.h"
 #include "bitboard.h"
 #include "types.h"
+#include "actstats.h"
+#include "batch.h"
+#include "dispatcher.h"
+#include "dlpack.h"
+#include "engine.h"
 #include "evaluate.h"
+#include "evalcache.h"
+#include "extract.h"
+#include "movebatch.h"
+#include "nnue_context.h"
+#include "perft.h"
+#include "pipeline.h"
+#include "score.h"
+#include "server.h"
+#include "uci.h"
 #include "nnue/network.h"
 #include "nnue/nnue_accumulator.h"
 #include "nnue/nnue_architecture.h"
+#include "syzygy/tbprobe.h"
+#include "tbbatch.h"
 
 namespace py = pybind11;
 
@@ -27,41 +53,101 @@ namespace Stockfish {
 std::tuple<py::array_t<float>, py::array_t<float>, py::array_t<float>, py::array_t<float>, py::array_t<float>, float, float>
 get_activations_and_eval(const std::string& fen);
 float get_evaluation(const std::string& fen);
+void set_eval_cache(size_t size_mb, size_t activation_slots);
+void clear_eval_cache();
+void release_eval_cache();
+py::dict get_eval_cache_stats();
+py::dict evaluate_batch(const std::vector<std::string>& fens, size_t threads, bool dedup, bool activations,
+                        bool tablebases, const std::string& planes, bool mirror,
+                        const std::map<std::string, py::array>& select, bool sparse, bool masks);
+std::vector<std::uint32_t> selection_indices(const std::string& name, const py::array& selection, size_t size);
+void allocate_planes(Batch::Outputs& out, py::dict& result, py::ssize_t n, const std::string& planes);
+void allocate_activations(Batch::Outputs& out, py::dict& result, py::ssize_t n);
+py::dict evaluate_batch_into(const std::vector<std::string>& fens, const std::map<std::string, py::object>& out,
+                             size_t threads, bool dedup, bool tablebases, bool mirror);
+py::dict evaluate_trajectory(const std::string& fen, const std::vector<std::string>& moves, bool activations);
+py::dict get_stats();
+int init_tablebases(const std::string& paths);
+py::dict probe_tablebases_batch(const std::vector<std::string>& fens, size_t threads, bool dtz);
+py::dict warm_tablebases(const std::vector<std::string>& materials, bool prefault, bool wait);
+py::dict get_tablebase_residency();
+py::dict legal_moves_batch(const std::vector<std::string>& fens, size_t threads, bool flags, bool decode);
+py::dict perft(const std::string& fen, int depth, size_t threads, size_t hash_mb, bool chess960);
+class SearchEngineHandle;
+SearchEngineHandle& search_engine();
+void set_search_option(const std::string& name, const py::object& value);
+void save_hash(const std::string& path);
+void load_hash(const std::string& path);
+std::pair<int, int> uci_score(const Score& score);
+void store_score(py::dict& d, const Score& score);
+Search::LimitsType search_limits(int depth, uint64_t nodes, int64_t movetime_ms);
+std::vector<py::list> analyze_games(const std::vector<std::tuple<std::string, std::vector<std::string>>>& games,
+                                    int depth, uint64_t nodes, int64_t movetime_ms, size_t workers);
+py::dict analyze_root_moves(const std::vector<std::string>& fens, int depth, uint64_t nodes, int64_t movetime_ms,
+                            size_t workers);
 py::dict get_network_info();
+py::dict rows_to_dict(const Batch::Outputs& out, size_t first, size_t count, bool activations);
+void copy_rows(const Batch::Outputs& batch, size_t first, size_t count, const Batch::Outputs& out);
+py::dict histogram_to_dict(const Batch::Histogram& h);
+py::object submit_async(Batch::Dispatcher& dispatcher, const std::vector<std::string>& fens, bool activations);
+void stop_dispatcher();
+py::object evaluate_async(const std::vector<std::string>& fens, bool activations);
+py::object activations_async(const std::vector<std::string>& fens);
+py::dict server_benchmark(const std::string& path, const std::vector<std::string>& fens, size_t connections,
+                          size_t pipeline, size_t positions, size_t requests, bool activations);
 
-// Global network instance
-static std::unique_ptr<Eval::NNUE::Networks> g_networks = nullptr;
+// Context of the C API behind the module: the networks, the evaluation cache
+// (disabled until set_eval_cache() is called) and the multithreaded batch
+// evaluator. Batches run with the GIL released, so its mutex keeps concurrent
+// Python threads from sharing the evaluator's extractors.
+static std::unique_ptr<nnue_context, decltype(&nnue_destroy)> g_context(nnue_create(0), &nnue_destroy);
 
-// Initialize the networks
+// Extraction context of the single position calls, used under g_context->mutex
+static std::unique_ptr<Extract::Extractor> g_extractor = nullptr;
+
+// Live handles (ActivationStats, Pipeline, Coalescer, Server) whose native
+// threads probe the evaluation cache without g_context->mutex. The cache cannot
+// be resized or cleared while there are any.
+static std::atomic<int> g_cacheUsers{0};
+
+struct CacheUser {
+    CacheUser() { ++g_cacheUsers; }
+    ~CacheUser() { --g_cacheUsers; }
+    
+    CacheUser(const CacheUser&) = delete;
+    CacheUser& operator=(const CacheUser&) = delete;
+};
+
+// Multithreaded Syzygy prober with per-thread result caches
+static Batch::Prober g_prober(std::thread::hardware_concurrency());
+static std::mutex g_proberMutex;
+
+// Multithreaded legal move generator, which keeps its buffers between calls
+static Batch::MoveGenerator g_moveGenerator(std::thread::hardware_concurrency());
+static std::mutex g_moveGeneratorMutex;
+
+// Background dispatcher of the async API, started on first use (under the GIL)
+static std::unique_ptr<Batch::Dispatcher> g_dispatcher = nullptr;
+
+
+// Load the default networks into the module's context
 void init_networks() {
-    if (g_networks == nullptr) {
-        // Initialize Stockfish
-        Bitboards::init();
-        Position::init();
-        
-        // Load the default networks
-        Eval::NNUE::EvalFile evalFileBig;
-        evalFileBig.defaultName = EvalFileDefaultNameBig;
-        evalFileBig.current = "";
-        
-        Eval::NNUE::EvalFile evalFileSmall;
-        evalFileSmall.defaultName = EvalFileDefaultNameSmall;
-        evalFileSmall.current = "";
+    if (g_context->networks == nullptr) {
+        if (nnue_load_networks(g_context.get(), nullptr, nullptr) != NNUE_OK)
+            throw std::runtime_error(nnue_last_error(g_context.get()));
         
-        auto networkBig = Eval::NNUE::NetworkBig(evalFileBig, Eval::NNUE::EmbeddedNNUEType::BIG);
-        auto networkSmall = Eval::NNUE::NetworkSmall(evalFileSmall, Eval::NNUE::EmbeddedNNUEType::SMALL);
-        
-        // Load the networks from default location
-        networkBig.load("", EvalFileDefaultNameBig);
-        networkSmall.load("", EvalFileDefaultNameSmall);
-        
-        g_networks = std::make_unique<Eval::NNUE::Networks>(
-            std::move(networkBig), 
-            std::move(networkSmall)
-        );
+        g_extractor = std::make_unique<Extract::Extractor>(*g_context->networks, &g_context->cache);
     }
 }
 
+// Hand a vector over to a numpy array, which frees it, without copying it
+template<typename T>
+py::array_t<T> to_array(std::vector<T>&& values, py::array::ShapeContainer shape) {
+    auto owned = std::make_unique<std::vector<T>>(std::move(values));
+    py::capsule owner(owned.get(), [](void* p) { delete static_cast<std::vector<T>*>(p); });
+    return py::array_t<T>(std::move(shape), owned.release()->data(), owner);
+}
+
 // Main function to extract activations and evaluation with intermediate layers
 std::tuple<py::array_t<float>, py::array_t<float>, py::array_t<float>, py::array_t<float>, py::array_t<float>, float, float> 
 get_activations_and_eval(const std::string& fen) {
@@ -74,23 +160,16 @@ get_activations_and_eval(const std::string& fen) {
     Position pos;
     pos.set(fen, false, &si);
     
-    // Create accumulator stack and caches
-    Eval::NNUE::AccumulatorStack accumulators;
-    auto caches = std::make_unique<Eval::NNUE::AccumulatorCaches>(*g_networks);
-    
-    // Determine which network to use
-    bool useSmallNet = Eval::use_smallnet(pos);
-    
-    // Evaluate the position to populate the accumulator
-    Value finalEval = Eval::evaluate(*g_networks, pos, accumulators, *caches, VALUE_ZERO);
-    
-    // Get the accumulator state
-    const auto& accumulatorState = accumulators.latest();
+    // Evaluate the position, keeping the activations of the network that produced the score
+    auto activations = std::make_unique<Extract::Activations>();
+    Extract::Score score;
+    {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock(g_context->mutex);
+        score = g_extractor->evaluate(pos, activations.get());
+    }
     
-    // Extract accumulator values (main hidden layer)
-    Eval::NNUE::IndexType accSize = useSmallNet 
-        ? Eval::NNUE::TransformedFeatureDimensionsSmall 
-        : Eval::NNUE::TransformedFeatureDimensionsBig;
+    const Eval::NNUE::IndexType accSize = activations->dimensions;
     
     // Create numpy arrays for accumulator (main hidden layer)
     auto accumulation_white = py::array_t<float>(accSize);
@@ -99,19 +178,9 @@ get_activations_and_eval(const std::string& fen) {
     auto acc_white_ptr = accumulation_white.mutable_unchecked<1>();
     auto acc_black_ptr = accumulation_black.mutable_unchecked<1>();
     
-    // Copy accumulator data
-    if (useSmallNet) {
-        const auto& acc = accumulatorState.acc<Eval::NNUE::TransformedFeatureDimensionsSmall>();
-        for (Eval::NNUE::IndexType i = 0; i < accSize; ++i) {
-            acc_white_ptr(i) = static_cast<float>(acc.accumulation[WHITE][i]);
-            acc_black_ptr(i) = static_cast<float>(acc.accumulation[BLACK][i]);
-        }
-    } else {
-        const auto& acc = accumulatorState.acc<Eval::NNUE::TransformedFeatureDimensionsBig>();
-        for (Eval::NNUE::IndexType i = 0; i < accSize; ++i) {
-            acc_white_ptr(i) = static_cast<float>(acc.accumulation[WHITE][i]);
-            acc_black_ptr(i) = static_cast<float>(acc.accumulation[BLACK][i]);
-        }
+    for (Eval::NNUE::IndexType i = 0; i < accSize; ++i) {
+        acc_white_ptr(i) = static_cast<float>(activations->accumulation[WHITE][i]);
+        acc_black_ptr(i) = static_cast<float>(activations->accumulation[BLACK][i]);
     }
     
     // Create numpy array for PSQT values (explicit ShapeContainer for older pybind11)
@@ -122,186 +191,1429 @@ get_activations_and_eval(const std::string& fen) {
     auto psqt_values = py::array_t<float>(psqt_shape);
     auto psqt_ptr = psqt_values.mutable_unchecked<2>();
     
-    // Copy PSQT data
-    if (useSmallNet) {
-        const auto& acc = accumulatorState.acc<Eval::NNUE::TransformedFeatureDimensionsSmall>();
-        for (int color = 0; color < 2; ++color) {
-            for (Eval::NNUE::IndexType bucket = 0; bucket < Eval::NNUE::PSQTBuckets; ++bucket) {
-                psqt_ptr(color, bucket) = static_cast<float>(acc.psqtAccumulation[color][bucket]);
-            }
-        }
-    } else {
-        const auto& acc = accumulatorState.acc<Eval::NNUE::TransformedFeatureDimensionsBig>();
-        for (int color = 0; color < 2; ++color) {
-            for (Eval::NNUE::IndexType bucket = 0; bucket < Eval::NNUE::PSQTBuckets; ++bucket) {
-                psqt_ptr(color, bucket) = static_cast<float>(acc.psqtAccumulation[color][bucket]);
-            }
+    for (int color = 0; color < 2; ++color) {
+        for (Eval::NNUE::IndexType bucket = 0; bucket < Eval::NNUE::PSQTBuckets; ++bucket) {
+            psqt_ptr(color, bucket) = static_cast<float>(activations->psqtAccumulation[color][bucket]);
         }
     }
     
+    // Layer 1 is the SqrClippedReLU output followed by the ClippedReLU output
+    auto layer1_out = py::array_t<float>(Extract::Layer1Size);
+    auto l1_ptr = layer1_out.mutable_unchecked<1>();
+    for (int i = 0; i < Extract::Layer1Size; ++i) {
+        l1_ptr(i) = static_cast<float>(activations->layer1[i]);
+    }
+    
+    auto layer2_out = py::array_t<float>(Extract::Layer2Size);
+    auto l2_ptr = layer2_out.mutable_unchecked<1>();
+    for (int i = 0; i < Extract::Layer2Size; ++i) {
+        l2_ptr(i) = static_cast<float>(activations->layer2[i]);
+    }
+    
     // Convert evaluation to centipawns
-    float finalEvalCp = static_cast<float>(finalEval) / 100.0f;
-    
-    // For now, return the same value for both positional and PSQT components
-    // In a full implementation, you might want to separate these
-    float psqtEvalCp = finalEvalCp;
-    
-    // Extract intermediate layer activations
-    // We need to manually transform the accumulator and propagate through layers
-    py::array_t<float> layer1_out;
-    py::array_t<float> layer2_out;
-    
-    const int bucket = (pos.count<ALL_PIECES>() - 1) / 4;
-    
-    if (useSmallNet) {
-        constexpr int L1 = Eval::NNUE::TransformedFeatureDimensionsSmall;
-        constexpr int L2 = Eval::NNUE::L2Small;
-        constexpr int L3 = Eval::NNUE::L3Small;
-        
-        const auto& acc = accumulatorState.acc<L1>();
-        
-        // Transform accumulator to uint8_t (clip to [0, 127])
-        alignas(64) std::uint8_t transformedFeatures[L1 * 2];
-        const Color perspectives[2] = {pos.side_to_move(), ~pos.side_to_move()};
-        
-        for (int p = 0; p < 2; ++p) {
-            const int offset = (L1 / 2) * p;
-            for (Eval::NNUE::IndexType i = 0; i < L1 / 2; ++i) {
-                // Clip and scale int16_t to uint8_t per Stockfish transformer: [0, 254] and /512
-                auto val0 = acc.accumulation[perspectives[p]][i];
-                auto val1 = acc.accumulation[perspectives[p]][i + L1 / 2];
-                
-                // Clamp to [0, 254]
-                val0 = std::max<std::int16_t>(0, std::min<std::int16_t>(254, val0));
-                val1 = std::max<std::int16_t>(0, std::min<std::int16_t>(254, val1));
-                
-                transformedFeatures[offset + i] = static_cast<std::uint8_t>((static_cast<unsigned>(val0) * static_cast<unsigned>(val1)) / 512);
+    float finalEvalCp = static_cast<float>(score.final) / 100.0f;
+    float psqtEvalCp = static_cast<float>(score.psqt) / 100.0f;
+    
+    return std::make_tuple(
+        accumulation_white,
+        accumulation_black, 
+        psqt_values,
+        layer1_out,
+        layer2_out,
+        finalEvalCp,
+        psqtEvalCp
+    );
+}
+
+// Simple function to get just the evaluation
+float get_evaluation(const std::string& fen) {
+    init_networks();
+    
+    StateInfo si;
+    Position pos;
+    pos.set(fen, false, &si);
+    
+    py::gil_scoped_release release;
+    std::lock_guard<std::mutex> lock(g_context->mutex);
+    return static_cast<float>(g_extractor->evaluate(pos).final) / 100.0f;
+}
+
+// Resize (or disable, with size_mb == 0) the shared evaluation cache
+void set_eval_cache(size_t size_mb, size_t activation_slots) {
+    release_eval_cache();
+    
+    py::gil_scoped_release release;
+    std::lock_guard<std::mutex> lock(g_context->mutex);
+    g_context->cache.resize(size_mb, activation_slots, sizeof(Extract::Activations));
+}
+
+void clear_eval_cache() {
+    release_eval_cache();
+    
+    py::gil_scoped_release release;
+    std::lock_guard<std::mutex> lock(g_context->mutex);
+    g_context->cache.clear();
+}
+
+// Makes sure that no native thread uses the evaluation cache outside of
+// g_context->mutex, before it is resized or cleared. The dispatcher of
+// evaluate_async() is stopped, and started again on its next use.
+void release_eval_cache() {
+    if (g_cacheUsers)
+        throw std::runtime_error("the evaluation cache is used by an ActivationStats, Pipeline, Coalescer or "
+                                 "Server object, which must be deleted first");
+    
+    if (g_dispatcher) {
+        stop_dispatcher();
+        g_dispatcher.reset();
+    }
+}
+
+// Hit/miss counters and occupancy of the evaluation cache
+py::dict get_eval_cache_stats() {
+    py::dict stats;
+    stats["enabled"] = g_context->cache.enabled();
+    stats["size_mb"] = g_context->cache.size_mb();
+    stats["activation_slots"] = g_context->cache.activation_slots();
+    stats["hits"] = g_context->cache.hits();
+    stats["misses"] = g_context->cache.misses();
+    stats["hashfull"] = g_context->cache.hashfull();
+    return stats;
+}
+
+// Neuron indices of a selection given either as a boolean mask over the tensor or
+// as a list of indices into it
+std::vector<std::uint32_t> selection_indices(const std::string& name, const py::array& selection, size_t size) {
+    if (selection.ndim() != 1)
+        throw py::value_error("selection for '" + name + "' must be one-dimensional");
+    
+    std::vector<std::uint32_t> index;
+    
+    if (py::isinstance<py::array_t<bool>>(selection)) {
+        auto mask = selection.cast<py::array_t<bool, py::array::c_style | py::array::forcecast>>();
+        if (static_cast<size_t>(mask.size()) != size)
+            throw py::value_error("mask for '" + name + "' must have " + std::to_string(size) + " entries");
+        
+        for (size_t i = 0; i < size; ++i)
+            if (mask.data()[i])
+                index.push_back(static_cast<std::uint32_t>(i));
+    }
+    else {
+        auto list = selection.cast<py::array_t<std::int64_t, py::array::c_style | py::array::forcecast>>();
+        for (py::ssize_t i = 0; i < list.size(); ++i) {
+            const std::int64_t idx = list.data()[i];
+            if (idx < 0 || idx >= static_cast<std::int64_t>(size))
+                throw py::value_error("index " + std::to_string(idx) + " out of range for '" + name + "'");
+            index.push_back(static_cast<std::uint32_t>(idx));
+        }
+    }
+    
+    if (index.empty())
+        throw py::value_error("selection for '" + name + "' is empty");
+    return index;
+}
+
+// Allocate the board plane arrays ("dense" or "packed") of n rows
+void allocate_planes(Batch::Outputs& out, py::dict& result, py::ssize_t n, const std::string& planes) {
+    if (planes == "dense") {
+        auto planes_out = py::array_t<std::uint8_t>(py::array::ShapeContainer{
+            n, static_cast<py::ssize_t>(Planes::PLANE_NB), static_cast<py::ssize_t>(SQUARE_NB)});
+        out.planes = planes_out.mutable_data();
+        result["planes"] = planes_out;
+    }
+    else if (planes == "packed") {
+        auto planes_out = py::array_t<std::uint64_t>(py::array::ShapeContainer{
+            n, static_cast<py::ssize_t>(Planes::PLANE_NB)});
+        out.packedPlanes = planes_out.mutable_data();
+        result["planes"] = planes_out;
+    }
+}
+
+// Allocate the activation arrays of n rows, as wide as the selections of out
+void allocate_activations(Batch::Outputs& out, py::dict& result, py::ssize_t n) {
+    auto acc_out = py::array_t<float>(py::array::ShapeContainer{
+        n, static_cast<py::ssize_t>(COLOR_NB), static_cast<py::ssize_t>(out.accumulation_width())});
+    auto psqt_acc_out = py::array_t<float>(py::array::ShapeContainer{
+        n, static_cast<py::ssize_t>(COLOR_NB), static_cast<py::ssize_t>(Eval::NNUE::PSQTBuckets)});
+    auto layer1_out = py::array_t<float>(py::array::ShapeContainer{
+        n, static_cast<py::ssize_t>(out.layer1_width())});
+    auto layer2_out = py::array_t<float>(py::array::ShapeContainer{
+        n, static_cast<py::ssize_t>(out.layer2_width())});
+    
+    out.accumulation = acc_out.mutable_data();
+    out.psqtAccumulation = psqt_acc_out.mutable_data();
+    out.layer1 = layer1_out.mutable_data();
+    out.layer2 = layer2_out.mutable_data();
+    
+    result["accumulation"] = acc_out;
+    result["psqt_accumulation"] = psqt_acc_out;
+    result["layer1"] = layer1_out;
+    result["layer2"] = layer2_out;
+}
+
+// Evaluate many positions on multiple threads. Duplicate positions (same hash key)
+// are evaluated once and their results copied to every row they appear in. With
+// tablebases, positions covered by the loaded Syzygy tables take their TB score.
+// Board planes ("dense" or "packed") are encoded from the same parsed positions.
+// With mirror, rows N..2N-1 hold the colour-flipped twins of rows 0..N-1.
+// select restricts the exported activations to a subset of the neurons of
+// "accumulation", "layer1" or "layer2", given as index lists or boolean masks.
+// With sparse, the nonzero transformed features are returned in CSR form, and
+// with masks, which neurons fired as one bit per neuron.
+py::dict evaluate_batch(const std::vector<std::string>& fens, size_t threads, bool dedup, bool activations,
+                        bool tablebases, const std::string& planes, bool mirror,
+                        const std::map<std::string, py::array>& select, bool sparse, bool masks) {
+    if (!planes.empty() && planes != "dense" && planes != "packed")
+        throw py::value_error("planes must be '', 'dense' or 'packed'");
+    if (!select.empty() && !activations)
+        throw py::value_error("select requires activations=True");
+    
+    std::vector<std::uint32_t> acc_index, layer1_index, layer2_index;
+    for (const auto& [name, selection] : select) {
+        if (name == "accumulation")
+            acc_index = selection_indices(name, selection, Extract::MaxDimensions);
+        else if (name == "layer1")
+            layer1_index = selection_indices(name, selection, Extract::Layer1Size);
+        else if (name == "layer2")
+            layer2_index = selection_indices(name, selection, Extract::Layer2Size);
+        else
+            throw py::value_error("cannot select neurons of '" + name + "'");
+    }
+    
+    init_networks();
+    
+    // Number of output rows
+    const py::ssize_t n = static_cast<py::ssize_t>(fens.size()) * (mirror ? 2 : 1);
+    
+    auto final_out = py::array_t<float>(n);
+    auto psqt_out = py::array_t<float>(n);
+    auto positional_out = py::array_t<float>(n);
+    auto small_net_out = py::array_t<std::uint8_t>(n);
+    
+    Batch::Outputs out;
+    out.final = final_out.mutable_data();
+    out.psqt = psqt_out.mutable_data();
+    out.positional = positional_out.mutable_data();
+    out.smallNet = small_net_out.mutable_data();
+    out.mirror = mirror;
+    out.sparseTransformed = sparse;
+    
+    py::dict result;
+    
+    if (tablebases) {
+        auto source_out = py::array_t<std::uint8_t>(n);
+        out.source = source_out.mutable_data();
+        result["source"] = source_out;
+    }
+    
+    allocate_planes(out, result, n, planes);
+    
+    if (masks) {
+        auto transformed_mask_out = py::array_t<std::uint64_t>(py::array::ShapeContainer{
+            n, static_cast<py::ssize_t>(Batch::MaskWords)});
+        auto layer_mask_out = py::array_t<std::uint64_t>(py::array::ShapeContainer{n, 2});
+        
+        out.transformedMask = transformed_mask_out.mutable_data();
+        out.layerMask = layer_mask_out.mutable_data();
+        
+        result["transformed_mask"] = transformed_mask_out;
+        result["layer_mask"] = layer_mask_out;
+    }
+    
+    if (activations) {
+        if (!acc_index.empty())
+            out.accumulationSelection = {acc_index.data(), acc_index.size()};
+        if (!layer1_index.empty())
+            out.layer1Selection = {layer1_index.data(), layer1_index.size()};
+        if (!layer2_index.empty())
+            out.layer2Selection = {layer2_index.data(), layer2_index.size()};
+        
+        allocate_activations(out, result, n);
+    }
+    
+    Batch::Stats stats;
+    std::vector<std::int64_t> sparseOffsets;
+    std::vector<std::uint16_t> sparseIndex;
+    std::vector<std::uint8_t> sparseValue;
+    {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock(g_context->mutex);
+        
+        if (threads)
+            g_context->evaluator->set_threads(threads);
+        
+        stats = g_context->evaluate(fens, out, dedup, tablebases);
+        
+        // The sparse buffers are only valid until the next batch, so they are
+        // copied out while the evaluator is still locked, into vectors that the
+        // arrays take over once the lock is released
+        if (sparse) {
+            const size_t total = g_context->evaluator->sparse_total();
+            
+            sparseOffsets.resize(static_cast<size_t>(n) + 1);
+            sparseIndex.resize(total);
+            sparseValue.resize(total);
+            
+            g_context->evaluator->write_sparse({sparseOffsets.data(), sparseIndex.data(), sparseValue.data()});
+        }
+    }
+    
+    if (sparse) {
+        const py::ssize_t total = static_cast<py::ssize_t>(sparseIndex.size());
+        
+        result["sparse_offsets"] = to_array(std::move(sparseOffsets), {n + 1});
+        result["sparse_index"] = to_array(std::move(sparseIndex), {total});
+        result["sparse_value"] = to_array(std::move(sparseValue), {total});
+    }
+    
+    result["eval"] = final_out;
+    result["eval_psqt"] = psqt_out;
+    result["eval_positional"] = positional_out;
+    result["small_net"] = small_net_out;
+    result["evaluated"] = stats.evaluated;
+    result["saved"] = stats.saved;
+    if (tablebases)
+        result["tablebase"] = stats.tablebase;
+    return result;
+}
+
+// Destination tensors of evaluate_batch_into(), borrowed through the DLPack
+// protocol so that the batch is written straight into memory the caller's
+// framework owns. The producers' deleters run (with the GIL held) on destruction.
+class DLPackOutputs {
+public:
+    explicit DLPackOutputs(const std::map<std::string, py::object>& tensors) : objects(tensors) {}
+    
+    DLPackOutputs(const DLPackOutputs&) = delete;
+    DLPackOutputs& operator=(const DLPackOutputs&) = delete;
+    
+    ~DLPackOutputs() {
+        for (auto* t : borrowed)
+            if (t->deleter)
+                t->deleter(t);
+    }
+    
+    // Data of the named tensor, which must be a C-contiguous CPU tensor of the
+    // given shape and element type, or nullptr if it was not passed
+    template<typename T>
+    T* get(const std::string& name, const std::vector<std::int64_t>& shape) {
+        auto it = objects.find(name);
+        if (it == objects.end())
+            return nullptr;
+        
+        py::object capsule = it->second.attr("__dlpack__")();
+        auto* managed = static_cast<DLPack::ManagedTensor*>(PyCapsule_GetPointer(capsule.ptr(), "dltensor"));
+        if (!managed)
+            throw py::error_already_set();
+        
+        // The capsule is consumed: it no longer deletes the tensor, we do
+        PyCapsule_SetName(capsule.ptr(), "used_dltensor");
+        borrowed.push_back(managed);
+        
+        const DLPack::Tensor& t = managed->dlTensor;
+        
+        if (t.device.deviceType != DLPack::kDLCPU)
+            throw py::value_error("'" + name + "' must be a CPU tensor");
+        if (!matches<T>(t.dtype))
+            throw py::type_error("'" + name + "' has the wrong dtype");
+        if (t.ndim != static_cast<std::int32_t>(shape.size()) || !std::equal(shape.begin(), shape.end(), t.shape))
+            throw py::value_error("'" + name + "' has the wrong shape");
+        
+        // Explicit strides are fine as long as they describe a compact row-major tensor
+        if (t.strides) {
+            std::int64_t stride = 1;
+            for (int d = t.ndim - 1; d >= 0; --d) {
+                if (shape[d] > 1 && t.strides[d] != stride)
+                    throw py::value_error("'" + name + "' must be C-contiguous");
+                stride *= shape[d];
             }
         }
         
-        // Now propagate through network layers to extract intermediate activations
-        const auto& net = g_networks->small.get_network(bucket);
-        
-        alignas(64) std::int32_t fc_0_out[L2 + 1];
-        alignas(64) std::uint8_t ac_sqr_0_out[L2 * 2];
-        alignas(64) std::uint8_t ac_0_out[L2];
-        alignas(64) std::int32_t fc_1_out[L3];
-        alignas(64) std::uint8_t ac_1_out[L3];
-        
-        // Propagate through layers
-        net.fc_0.propagate(transformedFeatures, fc_0_out);
-        net.ac_sqr_0.propagate(fc_0_out, ac_sqr_0_out);
-        net.ac_0.propagate(fc_0_out, ac_0_out);
-        
-        // Concatenate for layer 1 output
-        layer1_out = py::array_t<float>(L2 * 2);
-        auto l1_ptr = layer1_out.mutable_unchecked<1>();
-        for (int i = 0; i < L2; ++i) {
-            l1_ptr(i) = static_cast<float>(ac_sqr_0_out[i]);
-            l1_ptr(i + L2) = static_cast<float>(ac_0_out[i]);
+        return reinterpret_cast<T*>(static_cast<char*>(t.data) + t.byteOffset);
+    }
+    
+private:
+    template<typename T>
+    static bool matches(const DLPack::DataType& dtype) {
+        const bool code = std::is_floating_point_v<T> ? dtype.code == DLPack::kDLFloat
+                        // Signedness is not checked, torch has no unsigned 64-bit type
+                        : dtype.code == DLPack::kDLInt || dtype.code == DLPack::kDLUInt
+                          || (sizeof(T) == 1 && dtype.code == DLPack::kDLBool);
+        return code && dtype.bits == 8 * sizeof(T) && dtype.lanes == 1;
+    }
+    
+    std::map<std::string, py::object> objects;
+    std::vector<DLPack::ManagedTensor*> borrowed;
+};
+
+// Evaluate a batch straight into caller-owned tensors (anything implementing
+// __dlpack__ on the CPU, e.g. torch tensors or numpy arrays), keyed like the
+// arrays evaluate_batch() returns. Returns the batch statistics.
+py::dict evaluate_batch_into(const std::vector<std::string>& fens, const std::map<std::string, py::object>& out,
+                             size_t threads, bool dedup, bool tablebases, bool mirror) {
+    static const char* Names[] = {"eval", "eval_psqt", "eval_positional", "small_net", "source",
+                                  "accumulation", "psqt_accumulation", "layer1", "layer2",
+                                  "transformed_mask", "layer_mask", "planes"};
+    
+    for (const auto& [name, tensor] : out)
+        if (std::find(std::begin(Names), std::end(Names), name) == std::end(Names))
+            throw py::value_error("unknown output '" + name + "'");
+    
+    init_networks();
+    
+    const std::int64_t n = static_cast<std::int64_t>(fens.size()) * (mirror ? 2 : 1);
+    
+    DLPackOutputs tensors(out);
+    Batch::Outputs o;
+    o.mirror = mirror;
+    
+    auto get = [&](auto& field, const std::string& name, const std::vector<std::int64_t>& shape) {
+        field = tensors.get<std::remove_pointer_t<std::decay_t<decltype(field)>>>(name, shape);
+    };
+    
+    get(o.final, "eval", {n});
+    get(o.psqt, "eval_psqt", {n});
+    get(o.positional, "eval_positional", {n});
+    get(o.smallNet, "small_net", {n});
+    get(o.source, "source", {n});
+    get(o.accumulation, "accumulation", {n, COLOR_NB, Extract::MaxDimensions});
+    get(o.psqtAccumulation, "psqt_accumulation", {n, COLOR_NB, Eval::NNUE::PSQTBuckets});
+    get(o.layer1, "layer1", {n, Extract::Layer1Size});
+    get(o.layer2, "layer2", {n, Extract::Layer2Size});
+    get(o.transformedMask, "transformed_mask", {n, static_cast<std::int64_t>(Batch::MaskWords)});
+    get(o.layerMask, "layer_mask", {n, 2});
+    get(o.planes, "planes", {n, Planes::PLANE_NB, SQUARE_NB});
+    
+    Batch::Stats stats;
+    {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock(g_context->mutex);
+        
+        if (threads)
+            g_context->evaluator->set_threads(threads);
+        
+        stats = g_context->evaluate(fens, o, dedup, tablebases);
+    }
+    
+    py::dict result;
+    result["evaluated"] = stats.evaluated;
+    result["saved"] = stats.saved;
+    if (tablebases)
+        result["tablebase"] = stats.tablebase;
+    return result;
+}
+
+// Evaluate the positions of a game, through the C API: the one given by fen, then
+// the one after each move (UCI notation), in len(moves) + 1 rows
+py::dict evaluate_trajectory(const std::string& fen, const std::vector<std::string>& moves, bool activations) {
+    init_networks();
+    
+    const py::ssize_t n = static_cast<py::ssize_t>(moves.size() + 1);
+    
+    auto final_out = py::array_t<float>(n);
+    auto psqt_out = py::array_t<float>(n);
+    auto positional_out = py::array_t<float>(n);
+    auto small_net_out = py::array_t<std::uint8_t>(n);
+    
+    nnue_outputs out{};
+    out.eval = final_out.mutable_data();
+    out.eval_psqt = psqt_out.mutable_data();
+    out.eval_positional = positional_out.mutable_data();
+    out.small_net = small_net_out.mutable_data();
+    
+    py::dict result;
+    result["eval"] = final_out;
+    result["eval_psqt"] = psqt_out;
+    result["eval_positional"] = positional_out;
+    result["small_net"] = small_net_out;
+    
+    if (activations) {
+        Batch::Outputs o;
+        allocate_activations(o, result, n);
+        out.accumulation = o.accumulation;
+        out.psqt_accumulation = o.psqtAccumulation;
+        out.layer1 = o.layer1;
+        out.layer2 = o.layer2;
+    }
+    
+    std::vector<const char*> line;
+    for (const auto& m : moves)
+        line.push_back(m.c_str());
+    
+    nnue_status status;
+    std::string error;
+    {
+        py::gil_scoped_release release;
+        size_t rows;
+        status = nnue_evaluate_trajectory(g_context.get(), fen.c_str(), line.data(), line.size(), &out, &rows);
+        error = nnue_last_error(g_context.get());
+    }
+    
+    if (status == NNUE_ERROR_MOVE || status == NNUE_ERROR_ARGUMENT)
+        throw py::value_error(error);
+    if (status != NNUE_OK)
+        throw std::runtime_error(error);
+    return result;
+}
+
+// Counters of the module's batch evaluations (evaluate_batch, evaluate_batch_into,
+// evaluate_trajectory) and of the evaluation cache
+py::dict get_stats() {
+    nnue_stats s;
+    nnue_get_stats(g_context.get(), &s);
+    
+    py::dict result;
+    result["calls"] = s.calls;
+    result["positions"] = s.positions;
+    result["evaluated"] = s.evaluated;
+    result["duplicates"] = s.duplicates;
+    result["cache_hits"] = s.cache_hits;
+    result["cache_misses"] = s.cache_misses;
+    result["seconds"] = s.seconds;
+    return result;
+}
+
+// Load the Syzygy tables found in the given directories (":" separated, ";" on
+// Windows) and return the largest number of pieces they cover
+int init_tablebases(const std::string& paths) {
+    py::gil_scoped_release release;
+    std::scoped_lock lock(g_proberMutex, g_context->mutex);
+    Tablebases::init(paths);
+    g_prober.clear();
+    
+    // Without networks there is no evaluator yet, and one created later starts
+    // with an empty cache
+    if (g_context->evaluator)
+        g_context->evaluator->clear_tablebase_cache();
+    return Tablebases::MaxCardinality;
+}
+
+// Probe the WDL (and optionally DTZ) tables for many positions on multiple threads.
+// Probing needs no networks, only the bitboards, which the module's context set up.
+py::dict probe_tablebases_batch(const std::vector<std::string>& fens, size_t threads, bool dtz) {
+    const py::ssize_t n = static_cast<py::ssize_t>(fens.size());
+    
+    auto wdl_out = py::array_t<std::int8_t>(n);
+    auto wdl_status_out = py::array_t<std::int8_t>(n);
+    
+    Batch::TBOutputs out;
+    out.wdl = wdl_out.mutable_data();
+    out.wdlState = wdl_status_out.mutable_data();
+    
+    py::dict result;
+    
+    if (dtz) {
+        auto dtz_out = py::array_t<std::int16_t>(n);
+        auto dtz_status_out = py::array_t<std::int8_t>(n);
+        
+        out.dtz = dtz_out.mutable_data();
+        out.dtzState = dtz_status_out.mutable_data();
+        
+        result["dtz"] = dtz_out;
+        result["dtz_status"] = dtz_status_out;
+    }
+    
+    Batch::TBStats stats;
+    {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock(g_proberMutex);
+        
+        if (threads)
+            g_prober.set_threads(threads);
+        
+        stats = g_prober.probe(fens, out);
+    }
+    
+    result["wdl"] = wdl_out;
+    result["wdl_status"] = wdl_status_out;
+    result["probed"] = stats.probed;
+    result["cache_hits"] = stats.hits;
+    return result;
+}
+
+// Memory usage of the mapped tablebase files
+py::dict get_tablebase_residency() {
+    const Tablebases::Residency r = Tablebases::residency();
+    
+    py::dict info;
+    info["tables"] = r.tables;
+    info["mapped_bytes"] = r.mappedBytes;
+    info["index_bytes"] = r.indexBytes;
+    info["resident_bytes"] = r.residentBytes;
+    info["warming"] = r.warming;
+    return info;
+}
+
+// Load the index regions of the given tables (all if empty) on a background thread
+py::dict warm_tablebases(const std::vector<std::string>& materials, bool prefault, bool wait) {
+    {
+        py::gil_scoped_release release;
+        {
+            std::lock_guard<std::mutex> lock(g_proberMutex);
+            Tablebases::warm(materials, prefault);
         }
         
-        // Copy ac_0_out to second half of ac_sqr_0_out (as done in propagate)
-        std::memcpy(ac_sqr_0_out + L2, ac_0_out, L2 * sizeof(std::uint8_t));
+        if (wait)
+            Tablebases::wait_warm();
+    }
+    
+    return get_tablebase_residency();
+}
+
+// Generate the legal moves of many positions on multiple threads, in CSR form.
+// The number of moves is only known once they are generated, so they are written
+// into vectors that the arrays then take over.
+py::dict legal_moves_batch(const std::vector<std::string>& fens, size_t threads, bool flags, bool decode) {
+    const py::ssize_t n = static_cast<py::ssize_t>(fens.size());
+    
+    auto offsets_out = py::array_t<std::int64_t>(n + 1);
+    std::int64_t* offsets = offsets_out.mutable_data();
+    
+    std::vector<std::uint16_t> moves;
+    std::vector<std::int16_t> decoded;
+    std::vector<std::uint8_t> capture, givesCheck;
+    std::vector<std::int8_t> see;
+    {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock(g_moveGeneratorMutex);
         
-        // Continue propagation
-        net.fc_1.propagate(ac_sqr_0_out, fc_1_out);
-        net.ac_1.propagate(fc_1_out, ac_1_out);
+        if (threads)
+            g_moveGenerator.set_threads(threads);
         
-        // Copy layer 2 activations
-        layer2_out = py::array_t<float>(L3);
-        auto l2_ptr = layer2_out.mutable_unchecked<1>();
-        for (int i = 0; i < L3; ++i) {
-            l2_ptr(i) = static_cast<float>(ac_1_out[i]);
+        const size_t total = g_moveGenerator.generate(fens, flags);
+        
+        Batch::MoveOutputs out;
+        out.offsets = offsets;
+        
+        moves.resize(total);
+        out.moves = moves.data();
+        
+        if (decode) {
+            decoded.resize(total * 4);
+            out.decoded = decoded.data();
         }
         
-    } else {
-        constexpr int L1 = Eval::NNUE::TransformedFeatureDimensionsBig;
-        constexpr int L2 = Eval::NNUE::L2Big;
-        constexpr int L3 = Eval::NNUE::L3Big;
-        
-        const auto& acc = accumulatorState.acc<L1>();
-        
-        // Transform accumulator to uint8_t (clip to [0, 127])
-        alignas(64) std::uint8_t transformedFeatures[L1 * 2];
-        const Color perspectives[2] = {pos.side_to_move(), ~pos.side_to_move()};
-        
-        for (int p = 0; p < 2; ++p) {
-            const int offset = (L1 / 2) * p;
-            for (Eval::NNUE::IndexType i = 0; i < L1 / 2; ++i) {
-                // Clip and scale int16_t to uint8_t per Stockfish transformer: [0, 254] and /512
-                auto val0 = acc.accumulation[perspectives[p]][i];
-                auto val1 = acc.accumulation[perspectives[p]][i + L1 / 2];
-                
-                // Clamp to [0, 254]
-                val0 = std::max<std::int16_t>(0, std::min<std::int16_t>(254, val0));
-                val1 = std::max<std::int16_t>(0, std::min<std::int16_t>(254, val1));
-                
-                transformedFeatures[offset + i] = static_cast<std::uint8_t>((static_cast<unsigned>(val0) * static_cast<unsigned>(val1)) / 512);
+        if (flags) {
+            capture.resize(total);
+            givesCheck.resize(total);
+            see.resize(total);
+            
+            out.capture = capture.data();
+            out.givesCheck = givesCheck.data();
+            out.see = see.data();
+        }
+        
+        g_moveGenerator.write(out);
+    }
+    
+    const py::ssize_t m = static_cast<py::ssize_t>(moves.size());
+    
+    py::dict result;
+    
+    if (decode)
+        result["decoded"] = to_array(std::move(decoded), {m, static_cast<py::ssize_t>(4)});
+    
+    if (flags) {
+        result["capture"] = to_array(std::move(capture), {m});
+        result["gives_check"] = to_array(std::move(givesCheck), {m});
+        result["see"] = to_array(std::move(see), {m});
+    }
+    
+    result["offsets"] = offsets_out;
+    result["moves"] = to_array(std::move(moves), {m});
+    return result;
+}
+
+// Count the leaf nodes of the legal move tree on multiple threads, with per-move divide counts
+py::dict perft(const std::string& fen, int depth, size_t threads, size_t hash_mb, bool chess960) {
+    if (!threads)
+        threads = std::thread::hardware_concurrency();
+    
+    Benchmark::PerftResult r;
+    {
+        py::gil_scoped_release release;
+        r = Benchmark::parallel_perft(fen, depth, chess960, threads, hash_mb);
+    }
+    
+    py::dict divide;
+    for (const auto& [move, count] : r.divide)
+        divide[py::str(UCIEngine::move(move, chess960))] = count;
+    
+    py::dict result;
+    result["nodes"] = r.nodes;
+    result["divide"] = divide;
+    result["time_ms"] = r.elapsed;
+    result["nps"] = r.nodes * 1000 / std::max<TimePoint>(r.elapsed, 1);
+    return result;
+}
+
+// Score of a search in UCI terms, as centipawns and moves to mate (negative when
+// mated, 0 if the score is not a mate). Tablebase scores are 20000 centipawns
+// minus the plies to the conversion.
+std::pair<int, int> uci_score(const Score& score) {
+    if (score.is<Score::Mate>()) {
+        const int plies = score.get<Score::Mate>().plies;
+        return {0, (plies > 0 ? plies + 1 : plies) / 2};
+    }
+    
+    if (score.is<Score::Tablebase>()) {
+        const auto tb = score.get<Score::Tablebase>();
+        return {tb.win ? 20000 - tb.plies : -20000 - tb.plies, 0};
+    }
+    
+    return {score.get<Score::InternalUnits>().value, 0};
+}
+
+// Score of a search as the "score_cp" and "mate" keys of a dict, one of them None
+void store_score(py::dict& d, const Score& score) {
+    const auto [cp, mate] = uci_score(score);
+    
+    d["score_cp"] = py::none();
+    d["mate"] = py::none();
+    
+    if (score.is<Score::Mate>())
+        d["mate"] = mate;
+    else
+        d["score_cp"] = cp;
+}
+
+// Limits of the batch searches, one of which must end each search
+Search::LimitsType search_limits(int depth, uint64_t nodes, int64_t movetime_ms) {
+    if (depth <= 0 && !nodes && movetime_ms <= 0)
+        throw py::value_error("one of depth, nodes or movetime_ms must be set");
+    
+    Search::LimitsType limits;
+    limits.depth = std::max(depth, 0);
+    limits.nodes = nodes;
+    limits.movetime = std::max<int64_t>(movetime_ms, 0);
+    return limits;
+}
+
+// Search engine with its own options, threads and transposition table, or with
+// the table of another engine. Calls run with the GIL released, one at a time.
+class SearchEngineHandle {
+public:
+    // Loads the default networks: call without the GIL
+    SearchEngineHandle() : engine(std::make_unique<Engine>()) {
+        engine->set_on_verify_networks([](std::string_view) {});
+    }
+    
+    static std::unique_ptr<SearchEngineHandle> create(SearchEngineHandle* shareHashWith) {
+        py::gil_scoped_release release;
+        
+        auto handle = std::make_unique<SearchEngineHandle>();
+        if (shareHashWith) {
+            std::lock_guard<std::mutex> lock(shareHashWith->mutex);
+            handle->engine->share_tt(*shareHashWith->engine);
+        }
+        return handle;
+    }
+    
+    // Set a UCI option, such as Hash, Threads or SyzygyPath
+    void set_option(const std::string& name, const py::object& value) {
+        const std::string text = py::isinstance<py::bool_>(value) ? (value.cast<bool>() ? "true" : "false")
+                                                                   : std::string(py::str(value));
+        
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock(mutex);
+        
+        if (!engine->get_options().count(name))
+            throw py::value_error("unknown option " + name);
+        
+        // Only one engine may use a table while it is resized
+        if (name == "Hash" && engine->tt_shared())
+            throw std::runtime_error("cannot resize a transposition table shared with other engines");
+        
+        std::istringstream is("name " + name + " value " + text);
+        engine->get_options().setoption(is);
+    }
+    
+    // Save the transposition table to a file
+    void save_hash(const std::string& path) {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock(mutex);
+        
+        std::string error;
+        if (!engine->save_tt(path, error))
+            throw std::runtime_error(error);
+    }
+    
+    // Map the transposition table from a file written by save_hash() with the same
+    // engine version. Its size replaces the Hash option's.
+    void load_hash(const std::string& path) {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock(mutex);
+        
+        std::string error;
+        if (!engine->load_tt(path, error))
+            throw std::runtime_error(error);
+    }
+    
+    // Search with the transposition table of another engine from now on
+    void share_hash(SearchEngineHandle& other) {
+        if (&other == this)
+            throw py::value_error("an engine cannot share its own table");
+        
+        py::gil_scoped_release release;
+        std::scoped_lock lock(mutex, other.mutex);
+        engine->share_tt(*other.engine);
+    }
+    
+    // Search every position of the games on single-threaded workers sharing a
+    // transposition table, from the end of each game backwards
+    std::vector<py::list> analyze_games(const std::vector<std::tuple<std::string, std::vector<std::string>>>& games,
+                                            int depth, uint64_t nodes, int64_t movetime_ms, size_t workers) {
+        const Search::LimitsType limits = search_limits(depth, nodes, movetime_ms);
+    
+        std::vector<Batch::Game> list;
+        for (const auto& [fen, moves] : games)
+            list.push_back({fen, moves});
+    
+        std::vector<std::vector<Batch::PlyAnalysis>> analysis;
+        {
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock(mutex);
+            analysis = engine->analyze_games(list, limits, workers);
+        }
+    
+        std::vector<py::list> result;
+        for (const auto& game : analysis) {
+            py::list plies;
+            for (const auto& ply : game) {
+                py::dict d;
+                d["depth"] = ply.depth;
+                store_score(d, ply.score);
+                d["bound"] = ply.lowerbound ? "lowerbound" : ply.upperbound ? "upperbound" : "";
+                d["nodes"] = ply.nodes;
+                d["bestmove"] = ply.bestmove;
+                d["pv"] = ply.pv;
+                plies.append(d);
+            }
+            result.push_back(plies);
+        }
+        return result;
+    }
+    
+    // Search every legal move of the positions (MultiPV over all root moves) on the
+    // workers of analyze_games(), in CSR form: the moves of position i, best first,
+    // are rows offsets[i] to offsets[i + 1]
+    py::dict analyze_root_moves(const std::vector<std::string>& fens, int depth, uint64_t nodes, int64_t movetime_ms,
+                                    size_t workers) {
+        const Search::LimitsType limits = search_limits(depth, nodes, movetime_ms);
+    
+        std::vector<std::vector<Batch::RootMoveAnalysis>> analysis;
+        {
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock(mutex);
+            analysis = engine->analyze_root_moves(fens, limits, workers);
+        }
+    
+        size_t total = 0;
+        for (const auto& lines : analysis)
+            total += lines.size();
+    
+        const py::ssize_t n = static_cast<py::ssize_t>(fens.size());
+        const py::ssize_t m = static_cast<py::ssize_t>(total);
+    
+        auto offsets_out = py::array_t<std::int64_t>(n + 1);
+        auto moves_out = py::array_t<std::uint16_t>(m);
+        auto cp_out = py::array_t<std::int32_t>(m);
+        auto mate_out = py::array_t<std::int32_t>(m);
+        auto bound_out = py::array_t<std::int8_t>(m);
+        auto depth_out = py::array_t<std::int32_t>(m);
+        auto nodes_out = py::array_t<std::uint64_t>(m);
+        py::list uci;
+    
+        std::int64_t* offsets = offsets_out.mutable_data();
+        std::uint16_t* moves = moves_out.mutable_data();
+        std::int32_t* cp = cp_out.mutable_data();
+        std::int32_t* mate = mate_out.mutable_data();
+        std::int8_t* bound = bound_out.mutable_data();
+        std::int32_t* depths = depth_out.mutable_data();
+        std::uint64_t* searched = nodes_out.mutable_data();
+    
+        size_t row = 0;
+        offsets[0] = 0;
+        for (size_t i = 0; i < analysis.size(); ++i) {
+            for (const auto& line : analysis[i]) {
+                std::tie(cp[row], mate[row]) = uci_score(line.score);
+                moves[row] = line.move.raw();
+                bound[row] = line.lowerbound ? 1 : line.upperbound ? 2 : 0;
+                depths[row] = line.depth;
+                searched[row] = line.nodes;
+                uci.append(line.uci);
+                ++row;
             }
+            offsets[i + 1] = static_cast<std::int64_t>(row);
         }
+    
+        py::dict result;
+        result["offsets"] = offsets_out;
+        result["moves"] = moves_out;
+        result["uci"] = uci;
+        result["score_cp"] = cp_out;
+        result["mate"] = mate_out;
+        result["bound"] = bound_out;
+        result["depth"] = depth_out;
+        result["nodes"] = nodes_out;
+        return result;
+    }
+    
+private:
+    std::unique_ptr<Engine> engine;
+    std::mutex mutex;
+};
+
+// Engine of the module's search functions, created on first use. It loads the
+// default networks like the context, and keeps its options and transposition
+// table between calls.
+static std::unique_ptr<SearchEngineHandle> g_engine = nullptr;
+static std::mutex g_engineMutex;
+
+SearchEngineHandle& search_engine() {
+    py::gil_scoped_release release;
+    std::lock_guard<std::mutex> lock(g_engineMutex);
+    
+    if (!g_engine)
+        g_engine = std::make_unique<SearchEngineHandle>();
+    return *g_engine;
+}
+
+void set_search_option(const std::string& name, const py::object& value) {
+    search_engine().set_option(name, value);
+}
+
+void save_hash(const std::string& path) {
+    search_engine().save_hash(path);
+}
+
+void load_hash(const std::string& path) {
+    search_engine().load_hash(path);
+}
+
+std::vector<py::list> analyze_games(const std::vector<std::tuple<std::string, std::vector<std::string>>>& games,
+                                    int depth, uint64_t nodes, int64_t movetime_ms, size_t workers) {
+    return search_engine().analyze_games(games, depth, nodes, movetime_ms, workers);
+}
+
+py::dict analyze_root_moves(const std::vector<std::string>& fens, int depth, uint64_t nodes, int64_t movetime_ms,
+                            size_t workers) {
+    return search_engine().analyze_root_moves(fens, depth, nodes, movetime_ms, workers);
+}
+
+// Streaming activation statistics. Positions are evaluated on the native threads
+// and folded into per-thread accumulators, nothing is kept per position.
+class ActivationStatsHandle {
+public:
+    ActivationStatsHandle(size_t threads, int bins,
+                          const std::vector<std::tuple<std::string, size_t, size_t>>& covariance,
+                          float accumulation_range) {
+        if (!(accumulation_range > 0.0f))
+            throw py::value_error("accumulation_range must be positive");
+        
+        init_networks();
+        
+        std::vector<Batch::CovarianceBlock> blocks;
+        for (const auto& [name, begin, size] : covariance)
+            blocks.push_back({tensor_of(name), begin, size});
+        
+        stats = std::make_unique<Batch::ActivationStats>(
+            *g_context->networks, &g_context->cache, threads ? threads : std::thread::hardware_concurrency(), bins,
+            accumulation_range, blocks);
+    }
+    
+    void update(const std::vector<std::string>& fens) {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock(mutex);
+        stats->update(fens);
+    }
+    
+    void reset() {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats->reset();
+    }
+    
+    // Merged statistics, as {"big": {...}, "small": {...}}
+    py::dict result() {
+        std::lock_guard<std::mutex> lock(mutex);
         
-        // Now propagate through network layers to extract intermediate activations
-        const auto& net = g_networks->big.get_network(bucket);
-        
-        alignas(64) std::int32_t fc_0_out[L2 + 1];
-        alignas(64) std::uint8_t ac_sqr_0_out[L2 * 2];
-        alignas(64) std::uint8_t ac_0_out[L2];
-        alignas(64) std::int32_t fc_1_out[L3];
-        alignas(64) std::uint8_t ac_1_out[L3];
-        
-        // Propagate through layers
-        net.fc_0.propagate(transformedFeatures, fc_0_out);
-        net.ac_sqr_0.propagate(fc_0_out, ac_sqr_0_out);
-        net.ac_0.propagate(fc_0_out, ac_0_out);
-        
-        // Concatenate for layer 1 output
-        layer1_out = py::array_t<float>(L2 * 2);
-        auto l1_ptr = layer1_out.mutable_unchecked<1>();
-        for (int i = 0; i < L2; ++i) {
-            l1_ptr(i) = static_cast<float>(ac_sqr_0_out[i]);
-            l1_ptr(i + L2) = static_cast<float>(ac_0_out[i]);
+        py::dict result;
+        result["big"] = to_dict(stats->result(false));
+        result["small"] = to_dict(stats->result(true));
+        return result;
+    }
+    
+private:
+    static constexpr const char* TensorNames[] = {"accumulation", "transformed", "layer1", "layer2"};
+    
+    static Batch::Tensor tensor_of(const std::string& name) {
+        for (int t = 0; t < Batch::TENSOR_NB; ++t)
+            if (name == TensorNames[t])
+                return Batch::Tensor(t);
+        throw py::value_error("unknown tensor '" + name + "'");
+    }
+    
+    static py::dict to_dict(const Batch::NeuronStats& s) {
+        const double n = static_cast<double>(std::max<std::uint64_t>(s.count, 1));
+        
+        py::dict tensors;
+        for (int t = 0; t < Batch::TENSOR_NB; ++t) {
+            const size_t offset = s.offset(Batch::Tensor(t));
+            const size_t size = s.size(Batch::Tensor(t));
+            
+            // The accumulator is reported per perspective
+            py::array::ShapeContainer shape = t == Batch::TENSOR_ACCUMULATION
+                ? py::array::ShapeContainer{static_cast<py::ssize_t>(COLOR_NB), static_cast<py::ssize_t>(size / COLOR_NB)}
+                : py::array::ShapeContainer{static_cast<py::ssize_t>(size)};
+            py::array::ShapeContainer hist_shape{static_cast<py::ssize_t>(size), static_cast<py::ssize_t>(s.bins)};
+            
+            auto mean = py::array_t<double>(shape);
+            auto var = py::array_t<double>(shape);
+            auto min = py::array_t<float>(shape);
+            auto max = py::array_t<float>(shape);
+            auto sparsity = py::array_t<double>(shape);
+            auto hist = py::array_t<std::uint64_t>(hist_shape);
+            
+            double* mean_ptr = mean.mutable_data();
+            double* var_ptr = var.mutable_data();
+            float* min_ptr = min.mutable_data();
+            float* max_ptr = max.mutable_data();
+            double* sparsity_ptr = sparsity.mutable_data();
+            
+            for (size_t i = 0; i < size; ++i) {
+                mean_ptr[i] = s.mean[offset + i];
+                var_ptr[i] = s.m2[offset + i] / n;
+                min_ptr[i] = s.count ? s.min[offset + i] : 0.0f;
+                max_ptr[i] = s.count ? s.max[offset + i] : 0.0f;
+                sparsity_ptr[i] = 1.0 - static_cast<double>(s.nonzero[offset + i]) / n;
+            }
+            std::copy(s.histogram.begin() + offset * s.bins, s.histogram.begin() + (offset + size) * s.bins,
+                      hist.mutable_data());
+            
+            float lo, hi;
+            s.range(Batch::Tensor(t), lo, hi);
+            
+            py::dict d;
+            d["mean"] = mean;
+            d["var"] = var;
+            d["min"] = min;
+            d["max"] = max;
+            d["sparsity"] = sparsity;
+            d["hist"] = hist;
+            d["hist_range"] = std::make_tuple(lo, hi);
+            tensors[TensorNames[t]] = d;
         }
         
-        // Copy ac_0_out to second half of ac_sqr_0_out (as done in propagate)
-        std::memcpy(ac_sqr_0_out + L2, ac_0_out, L2 * sizeof(std::uint8_t));
+        py::list covariances;
+        for (const auto& c : s.covariances) {
+            const py::ssize_t size = static_cast<py::ssize_t>(c.block.size);
+            
+            auto mean = py::array_t<double>(size);
+            auto cov = py::array_t<double>(py::array::ShapeContainer{size, size});
+            
+            std::copy(c.mean.begin(), c.mean.end(), mean.mutable_data());
+            std::transform(c.comoment.begin(), c.comoment.end(), cov.mutable_data(),
+                           [n](double m) { return m / n; });
+            
+            py::dict d;
+            d["tensor"] = TensorNames[c.block.tensor];
+            d["begin"] = c.block.begin;
+            d["mean"] = mean;
+            d["cov"] = cov;
+            covariances.append(d);
+        }
+        
+        py::dict result;
+        result["count"] = s.count;
+        result["tensors"] = tensors;
+        result["covariance"] = covariances;
+        return result;
+    }
+    
+    CacheUser cacheUser;
+    std::unique_ptr<Batch::ActivationStats> stats;
+    std::mutex mutex;
+};
+
+// Staged extraction pipeline (parse -> evaluate -> write) with per-stage counters
+class PipelineHandle {
+public:
+    PipelineHandle(size_t parse_threads, size_t eval_threads, size_t write_threads, size_t queue_size) {
+        init_networks();
+        
+        Batch::PipelineConfig config;
+        config.threads[Batch::STAGE_PARSE] = parse_threads;
+        config.threads[Batch::STAGE_EVALUATE] = eval_threads ? eval_threads : std::thread::hardware_concurrency();
+        config.threads[Batch::STAGE_WRITE] = write_threads;
+        config.queueSize = queue_size;
+        
+        pipeline = std::make_unique<Batch::Pipeline>(*g_context->networks, &g_context->cache, config);
+    }
+    
+    py::dict run(const std::vector<std::string>& fens, bool activations, const std::string& planes) {
+        if (!planes.empty() && planes != "dense" && planes != "packed")
+            throw py::value_error("planes must be '', 'dense' or 'packed'");
+        
+        const py::ssize_t n = static_cast<py::ssize_t>(fens.size());
+        
+        auto final_out = py::array_t<float>(n);
+        auto psqt_out = py::array_t<float>(n);
+        auto positional_out = py::array_t<float>(n);
+        auto small_net_out = py::array_t<std::uint8_t>(n);
+        
+        Batch::Outputs out;
+        out.final = final_out.mutable_data();
+        out.psqt = psqt_out.mutable_data();
+        out.positional = positional_out.mutable_data();
+        out.smallNet = small_net_out.mutable_data();
+        
+        py::dict result;
+        result["eval"] = final_out;
+        result["eval_psqt"] = psqt_out;
+        result["eval_positional"] = positional_out;
+        result["small_net"] = small_net_out;
         
-        // Continue propagation
-        net.fc_1.propagate(ac_sqr_0_out, fc_1_out);
-        net.ac_1.propagate(fc_1_out, ac_1_out);
+        allocate_planes(out, result, n, planes);
+        if (activations)
+            allocate_activations(out, result, n);
         
-        // Copy layer 2 activations
-        layer2_out = py::array_t<float>(L3);
-        auto l2_ptr = layer2_out.mutable_unchecked<1>();
-        for (int i = 0; i < L3; ++i) {
-            l2_ptr(i) = static_cast<float>(ac_1_out[i]);
+        {
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock(mutex);
+            pipeline->run(fens, out);
         }
+        return result;
     }
     
-    return std::make_tuple(
-        accumulation_white,
-        accumulation_black, 
-        psqt_values,
-        layer1_out,
-        layer2_out,
-        finalEvalCp,
-        psqtEvalCp
-    );
+    // Counters per stage since creation or the last reset. "throughput" is the
+    // rate the stage could sustain on its own (items per busy second of the
+    // stage's thread group), so the stage with the lowest one is the bottleneck.
+    py::dict stats() const {
+        static constexpr const char* StageNames[] = {"parse", "evaluate", "write"};
+        
+        py::dict result;
+        for (int s = 0; s < Batch::STAGE_NB; ++s) {
+            const Batch::StageStats st = pipeline->stats(Batch::Stage(s));
+            const size_t threads = pipeline->config().threads[s];
+            const double busy = st.busyNs / 1e9;
+            
+            py::dict d;
+            d["threads"] = threads;
+            d["items"] = st.items;
+            d["busy_s"] = busy;
+            d["starved_s"] = st.starvedNs / 1e9;
+            d["blocked_s"] = st.blockedNs / 1e9;
+            d["throughput"] = busy > 0 ? st.items * threads / busy : 0.0;
+            result[StageNames[s]] = d;
+        }
+        return result;
+    }
+    
+    void reset_stats() {
+        pipeline->reset_stats();
+    }
+    
+private:
+    CacheUser cacheUser;
+    std::unique_ptr<Batch::Pipeline> pipeline;
+    std::mutex mutex;
+};
+
+// Copy rows [first, first + count) of a batch into a dict of numpy arrays
+py::dict rows_to_dict(const Batch::Outputs& out, size_t first, size_t count, bool activations) {
+    const py::ssize_t n = static_cast<py::ssize_t>(count);
+    
+    auto rows = [&](const auto* data, size_t width, py::array::ShapeContainer shape) {
+        using T = std::remove_const_t<std::remove_pointer_t<decltype(data)>>;
+        auto array = py::array_t<T>(shape);
+        std::copy(data + first * width, data + (first + count) * width, array.mutable_data());
+        return array;
+    };
+    
+    py::dict result;
+    result["eval"] = rows(out.final, 1, {n});
+    result["eval_psqt"] = rows(out.psqt, 1, {n});
+    result["eval_positional"] = rows(out.positional, 1, {n});
+    result["small_net"] = rows(out.smallNet, 1, {n});
+    
+    if (activations) {
+        result["accumulation"] = rows(out.accumulation, COLOR_NB * Extract::MaxDimensions,
+            {n, static_cast<py::ssize_t>(COLOR_NB), static_cast<py::ssize_t>(Extract::MaxDimensions)});
+        result["psqt_accumulation"] = rows(out.psqtAccumulation, COLOR_NB * Eval::NNUE::PSQTBuckets,
+            {n, static_cast<py::ssize_t>(COLOR_NB), static_cast<py::ssize_t>(Eval::NNUE::PSQTBuckets)});
+        result["layer1"] = rows(out.layer1, Extract::Layer1Size, {n, static_cast<py::ssize_t>(Extract::Layer1Size)});
+        result["layer2"] = rows(out.layer2, Extract::Layer2Size, {n, static_cast<py::ssize_t>(Extract::Layer2Size)});
+    }
+    return result;
 }
 
-// Simple function to get just the evaluation
-float get_evaluation(const std::string& fen) {
+// Copy rows [first, first + count) of a batch into rows 0..count-1 of out,
+// which has the same outputs (at full width)
+void copy_rows(const Batch::Outputs& batch, size_t first, size_t count, const Batch::Outputs& out) {
+    auto rows = [&](const auto* src, auto* dst, size_t width) {
+        if (dst)
+            std::copy(src + first * width, src + (first + count) * width, dst);
+    };
+    
+    rows(batch.final, out.final, 1);
+    rows(batch.psqt, out.psqt, 1);
+    rows(batch.positional, out.positional, 1);
+    rows(batch.smallNet, out.smallNet, 1);
+    rows(batch.accumulation, out.accumulation, COLOR_NB * Extract::MaxDimensions);
+    rows(batch.psqtAccumulation, out.psqtAccumulation, COLOR_NB * Eval::NNUE::PSQTBuckets);
+    rows(batch.layer1, out.layer1, Extract::Layer1Size);
+    rows(batch.layer2, out.layer2, Extract::Layer2Size);
+}
+
+// Summary and non-empty buckets of a latency or size histogram
+py::dict histogram_to_dict(const Batch::Histogram& h) {
+    std::vector<std::uint64_t> bounds, counts;
+    for (int i = 0; i < Batch::Histogram::Size; ++i)
+        if (h[i]) {
+            bounds.push_back(Batch::Histogram::lower_bound(i));
+            counts.push_back(h[i]);
+        }
+    
+    py::dict d;
+    d["count"] = h.count();
+    d["mean"] = h.mean();
+    d["max"] = h.max();
+    d["p50"] = h.quantile(0.50);
+    d["p90"] = h.quantile(0.90);
+    d["p99"] = h.quantile(0.99);
+    d["p999"] = h.quantile(0.999);
+    d["bounds"] = py::array_t<std::uint64_t>(static_cast<py::ssize_t>(bounds.size()), bounds.data());
+    d["counts"] = py::array_t<std::uint64_t>(static_cast<py::ssize_t>(counts.size()), counts.data());
+    return d;
+}
+
+// Completes pending requests and joins the dispatcher. Registered with atexit,
+// as completions need the interpreter.
+void stop_dispatcher() {
+    if (g_dispatcher) {
+        py::gil_scoped_release release;
+        g_dispatcher->stop();
+    }
+}
+
+// Queue a request without blocking the calling event loop. Returns an asyncio
+// future that is resolved from the dispatcher thread through
+// loop.call_soon_threadsafe().
+py::object submit_async(Batch::Dispatcher& dispatcher, const std::vector<std::string>& fens, bool activations) {
+    struct AsyncCall {
+        py::object loop, future;
+    };
+    
+    py::object loop = py::module_::import("asyncio").attr("get_running_loop")();
+    
+    // Owned by the completion once submitted, which deletes it with the GIL held
+    // (so not before this call returns)
+    auto pending = std::make_unique<AsyncCall>();
+    pending->loop = loop;
+    pending->future = loop.attr("create_future")();
+    py::object future = pending->future;
+    AsyncCall* call = pending.get();
+    
+    dispatcher.submit(fens, activations, [call, activations](const Batch::Outputs& out, size_t first, size_t count) {
+        py::gil_scoped_acquire acquire;
+        std::unique_ptr<AsyncCall> owned(call);
+        
+        try {
+            py::dict result = rows_to_dict(out, first, count, activations);
+            
+            // Runs on the loop; the caller may have cancelled the future meanwhile
+            auto resolve = py::cpp_function([](py::object f, py::object r) {
+                if (!f.attr("done")().cast<bool>())
+                    f.attr("set_result")(r);
+            });
+            owned->loop.attr("call_soon_threadsafe")(resolve, owned->future, result);
+        }
+        catch (py::error_already_set&) {
+            // The loop is closed, nobody is waiting for the result anymore
+        }
+    });
+    pending.release();
+    
+    return future;
+}
+
+// Evaluate positions on the native pool without blocking the calling event loop.
+// Requests pending at the same time share a batch.
+py::object evaluate_async(const std::vector<std::string>& fens, bool activations) {
     init_networks();
     
-    StateInfo si;
-    Position pos;
-    pos.set(fen, false, &si);
+    if (!g_dispatcher) {
+        g_dispatcher = std::make_unique<Batch::Dispatcher>(
+            *g_context->networks, &g_context->cache, std::thread::hardware_concurrency(), 4096);
+        py::module_::import("atexit").attr("register")(py::cpp_function(&stop_dispatcher));
+    }
+    
+    return submit_async(*g_dispatcher, fens, activations);
+}
+
+py::object activations_async(const std::vector<std::string>& fens) {
+    return evaluate_async(fens, true);
+}
+
+// Latency-bounded micro-batching for serving. Requests from any number of
+// threads or coroutines are held until max_batch positions are pending or the
+// oldest has waited max_delay_us, then evaluated as one batch.
+class CoalescerHandle {
+public:
+    CoalescerHandle(size_t threads, size_t max_batch, std::uint64_t max_delay_us) {
+        init_networks();
+        dispatcher = std::make_unique<Batch::Dispatcher>(
+            *g_context->networks, &g_context->cache, threads ? threads : std::thread::hardware_concurrency(),
+            max_batch, max_delay_us);
+    }
+    
+    // Completions of evaluate_async() need the GIL, so the dispatcher is joined without it
+    ~CoalescerHandle() {
+        py::gil_scoped_release release;
+        dispatcher.reset();
+    }
+    
+    // Blocks the calling thread (without the GIL) until the batch holding the
+    // request is done. The dispatcher copies the rows out, the GIL is not needed.
+    py::dict evaluate(const std::vector<std::string>& fens, bool activations) {
+        const py::ssize_t n = static_cast<py::ssize_t>(fens.size());
+        
+        auto final_out = py::array_t<float>(n);
+        auto psqt_out = py::array_t<float>(n);
+        auto positional_out = py::array_t<float>(n);
+        auto small_net_out = py::array_t<std::uint8_t>(n);
+        
+        Batch::Outputs out;
+        out.final = final_out.mutable_data();
+        out.psqt = psqt_out.mutable_data();
+        out.positional = positional_out.mutable_data();
+        out.smallNet = small_net_out.mutable_data();
+        
+        py::dict result;
+        result["eval"] = final_out;
+        result["eval_psqt"] = psqt_out;
+        result["eval_positional"] = positional_out;
+        result["small_net"] = small_net_out;
+        
+        if (activations)
+            allocate_activations(out, result, n);
+        
+        {
+            py::gil_scoped_release release;
+            
+            std::promise<void> done;
+            std::future<void> ready = done.get_future();
+            
+            dispatcher->submit(fens, activations, [&](const Batch::Outputs& batch, size_t first, size_t count) {
+                copy_rows(batch, first, count, out);
+                done.set_value();
+            });
+            ready.wait();
+        }
+        return result;
+    }
+    
+    py::object evaluate_async(const std::vector<std::string>& fens, bool activations) {
+        return submit_async(*dispatcher, fens, activations);
+    }
+    
+    // Request latencies (submit to batch done, in microseconds), positions per
+    // batch and requests per batch, since creation or the last reset
+    py::dict stats() const {
+        const Batch::DispatcherStats s = dispatcher->stats();
+        
+        py::dict result;
+        result["latency_us"] = histogram_to_dict(s.latencyUs);
+        result["batch_size"] = histogram_to_dict(s.batchSize);
+        result["requests_per_batch"] = histogram_to_dict(s.requests);
+        return result;
+    }
+    
+    void reset_stats() {
+        dispatcher->reset_stats();
+    }
+    
+private:
+    CacheUser cacheUser;
+    std::unique_ptr<Batch::Dispatcher> dispatcher;
+};
+
+// Evaluation server on a Unix domain socket, for clients outside Python. Its
+// threads never take the GIL.
+class ServerHandle {
+public:
+    ServerHandle(const std::string& path, size_t threads, size_t max_batch, std::uint64_t max_delay_us,
+                 size_t max_in_flight) {
+        init_networks();
+        
+        Batch::ServerConfig config;
+        config.threads = threads ? threads : std::thread::hardware_concurrency();
+        config.maxBatch = max_batch;
+        config.maxDelayUs = max_delay_us;
+        config.maxInFlight = max_in_flight;
+        
+        server = std::make_unique<Batch::Server>(*g_context->networks, &g_context->cache, config);
+        if (!server->start(path))
+            throw std::runtime_error(server->error());
+    }
     
-    Eval::NNUE::AccumulatorStack accumulators;
-    auto caches = std::make_unique<Eval::NNUE::AccumulatorCaches>(*g_networks);
+    ~ServerHandle() {
+        py::gil_scoped_release release;
+        server.reset();
+    }
+    
+    void stop() {
+        py::gil_scoped_release release;
+        server->stop();
+    }
     
-    Value finalEval = Eval::evaluate(*g_networks, pos, accumulators, *caches, VALUE_ZERO);
-    return static_cast<float>(finalEval) / 100.0f;
+    py::dict stats() const {
+        const Batch::DispatcherStats s = server->stats();
+        
+        py::dict result;
+        result["connections"] = server->connections();
+        result["latency_us"] = histogram_to_dict(s.latencyUs);
+        result["batch_size"] = histogram_to_dict(s.batchSize);
+        result["requests_per_batch"] = histogram_to_dict(s.requests);
+        return result;
+    }
+    
+    void reset_stats() {
+        server->reset_stats();
+    }
+    
+private:
+    CacheUser cacheUser;
+    std::unique_ptr<Batch::Server> server;
+};
+
+// Loopback load generator for a Server: throughput and round trip latencies
+py::dict server_benchmark(const std::string& path, const std::vector<std::string>& fens, size_t connections,
+                          size_t pipeline, size_t positions, size_t requests, bool activations) {
+    Batch::ClientConfig config;
+    config.connections = connections;
+    config.pipeline = pipeline;
+    config.positions = positions;
+    config.requests = requests;
+    config.activations = activations;
+    
+    Batch::ClientStats s;
+    {
+        py::gil_scoped_release release;
+        s = Batch::run_client(path, fens, config);
+    }
+    if (!s.error.empty())
+        throw std::runtime_error(s.error);
+    
+    py::dict result;
+    result["requests"] = s.requests;
+    result["positions"] = s.positions;
+    result["errors"] = s.errors;
+    result["seconds"] = s.seconds;
+    result["requests_per_s"] = s.seconds > 0 ? s.requests / s.seconds : 0.0;
+    result["positions_per_s"] = s.seconds > 0 ? s.positions / s.seconds : 0.0;
+    result["latency_us"] = histogram_to_dict(s.latencyUs);
+    return result;
 }
 
 // Get network architecture information
@@ -314,6 +1626,7 @@ py::dict get_network_info() {
     info["L3Big"] = Eval::NNUE::L3Big;
     info["L2Small"] = Eval::NNUE::L2Small;
     info["L3Small"] = Eval::NNUE::L3Small;
+    info["BoardPlanes"] = static_cast<int>(Planes::PLANE_NB);
     return info;
 }
 
@@ -332,4 +1645,168 @@ PYBIND11_MODULE(stockfish_nnue, m) {
     
     m.def("get_network_info", &Stockfish::get_network_info,
           "Get network architecture information");
+    
+    m.def("set_eval_cache", &Stockfish::set_eval_cache,
+          "Resize the shared evaluation cache (0 MB disables it), optionally caching activations",
+          py::arg("size_mb"), py::arg("activation_slots") = 0);
+    
+    m.def("clear_eval_cache", &Stockfish::clear_eval_cache,
+          "Empty the evaluation cache and reset its counters");
+    
+    m.def("get_eval_cache_stats", &Stockfish::get_eval_cache_stats,
+          "Get evaluation cache hit/miss counters and occupancy");
+    
+    m.def("evaluate_batch", &Stockfish::evaluate_batch,
+          "Evaluate a batch of positions on multiple threads, evaluating duplicates once",
+          py::arg("fens"), py::arg("threads") = 0, py::arg("dedup") = true,
+          py::arg("activations") = false, py::arg("tablebases") = false, py::arg("planes") = "",
+          py::arg("mirror") = false, py::arg("select") = std::map<std::string, py::array>(),
+          py::arg("sparse") = false, py::arg("masks") = false);
+    
+    m.def("evaluate_batch_into", &Stockfish::evaluate_batch_into,
+          "Evaluate a batch of positions into caller-owned DLPack tensors (e.g. torch tensors)",
+          py::arg("fens"), py::arg("out"), py::arg("threads") = 0, py::arg("dedup") = true,
+          py::arg("tablebases") = false, py::arg("mirror") = false);
+    
+    m.def("evaluate_trajectory", &Stockfish::evaluate_trajectory,
+          "Evaluate the positions along a game, from a FEN and its moves in UCI notation",
+          py::arg("fen"), py::arg("moves"), py::arg("activations") = false);
+    
+    m.def("get_stats", &Stockfish::get_stats,
+          "Get the batch evaluation counters of the module");
+    
+    m.def("evaluate_async", &Stockfish::evaluate_async,
+          "Evaluate a batch of positions on the native pool, returning an awaitable asyncio future",
+          py::arg("fens"), py::arg("activations") = false);
+    
+    m.def("activations_async", &Stockfish::activations_async,
+          "Like evaluate_async, with the activations of the network that produced each score",
+          py::arg("fens"));
+    
+    m.def("init_tablebases", &Stockfish::init_tablebases,
+          "Load Syzygy tablebases from the given paths, returning the largest piece count covered",
+          py::arg("paths"));
+    
+    m.def("probe_tablebases_batch", &Stockfish::probe_tablebases_batch,
+          "Probe the Syzygy WDL (and DTZ) tables for a batch of positions on multiple threads",
+          py::arg("fens"), py::arg("threads") = 0, py::arg("dtz") = true);
+    
+    m.def("warm_tablebases", &Stockfish::warm_tablebases,
+          "Page in the indices of the given Syzygy tables (all if empty) on a background thread",
+          py::arg("materials") = std::vector<std::string>(), py::arg("prefault") = false,
+          py::arg("wait") = false);
+    
+    m.def("legal_moves_batch", &Stockfish::legal_moves_batch,
+          "Generate the legal moves of a batch of positions on multiple threads, in CSR form",
+          py::arg("fens"), py::arg("threads") = 0, py::arg("flags") = false,
+          py::arg("decode") = false);
+    
+    m.def("perft", &Stockfish::perft,
+          "Count legal move tree leaves on multiple threads, with divide counts and nodes/sec",
+          py::arg("fen"), py::arg("depth"), py::arg("threads") = 0, py::arg("hash_mb") = 16,
+          py::arg("chess960") = false);
+    
+    m.def("set_search_option", &Stockfish::set_search_option,
+          "Set a UCI option (Hash, Threads, SyzygyPath, ...) of the engine behind the search functions",
+          py::arg("name"), py::arg("value"));
+    
+    py::class_<Stockfish::SearchEngineHandle>(m, "SearchEngine",
+          "Search engine with its own options and threads, and its own transposition table or another engine's")
+        .def(py::init(&Stockfish::SearchEngineHandle::create), py::arg("share_hash_with") = nullptr)
+        .def("set_option", &Stockfish::SearchEngineHandle::set_option,
+             "Set a UCI option of the engine", py::arg("name"), py::arg("value"))
+        .def("save_hash", &Stockfish::SearchEngineHandle::save_hash,
+             "Save the transposition table to a file", py::arg("path"))
+        .def("load_hash", &Stockfish::SearchEngineHandle::load_hash,
+             "Map the transposition table from a file written by save_hash()", py::arg("path"))
+        .def("share_hash", &Stockfish::SearchEngineHandle::share_hash,
+             "Search with the transposition table of another engine from now on", py::arg("other"))
+        .def("analyze_games", &Stockfish::SearchEngineHandle::analyze_games,
+             "Search every position of games on single-threaded workers sharing the transposition table",
+             py::arg("games"), py::arg("depth") = 0, py::arg("nodes") = 0, py::arg("movetime_ms") = 0,
+             py::arg("workers") = 0)
+        .def("analyze_root_moves", &Stockfish::SearchEngineHandle::analyze_root_moves,
+             "Search every legal move of a batch of positions into CSR arrays",
+             py::arg("fens"), py::arg("depth") = 0, py::arg("nodes") = 0, py::arg("movetime_ms") = 0,
+             py::arg("workers") = 0);
+    
+    m.def("save_hash", &Stockfish::save_hash,
+          "Save the search engine's transposition table to a file",
+          py::arg("path"));
+    
+    m.def("load_hash", &Stockfish::load_hash,
+          "Map the search engine's transposition table from a file written by save_hash()",
+          py::arg("path"));
+    
+    m.def("analyze_games", &Stockfish::analyze_games,
+          "Search every position of games on single-threaded workers sharing a transposition table",
+          py::arg("games"), py::arg("depth") = 0, py::arg("nodes") = 0, py::arg("movetime_ms") = 0,
+          py::arg("workers") = 0);
+    
+    m.def("analyze_root_moves", &Stockfish::analyze_root_moves,
+          "Search every legal move of a batch of positions (MultiPV over all root moves) into CSR arrays",
+          py::arg("fens"), py::arg("depth") = 0, py::arg("nodes") = 0, py::arg("movetime_ms") = 0,
+          py::arg("workers") = 0);
+    
+    py::class_<Stockfish::ActivationStatsHandle>(m, "ActivationStats",
+          "Streaming per-neuron statistics (mean, variance, min/max, sparsity, histograms, covariance blocks)")
+        .def(py::init<size_t, int, const std::vector<std::tuple<std::string, size_t, size_t>>&, float>(),
+             py::arg("threads") = 0, py::arg("bins") = 32,
+             py::arg("covariance") = std::vector<std::tuple<std::string, size_t, size_t>>(),
+             py::arg("accumulation_range") = 4096.0f)
+        .def("update", &Stockfish::ActivationStatsHandle::update,
+             "Evaluate a batch of positions and fold their activations into the statistics",
+             py::arg("fens"))
+        .def("reset", &Stockfish::ActivationStatsHandle::reset,
+             "Forget all positions seen so far")
+        .def("result", &Stockfish::ActivationStatsHandle::result,
+             "Get the merged statistics of the big and the small network");
+    
+    py::class_<Stockfish::PipelineHandle>(m, "Pipeline",
+          "Multi-stage extraction pipeline with bounded queues between its stages")
+        .def(py::init<size_t, size_t, size_t, size_t>(),
+             py::arg("parse_threads") = 1, py::arg("eval_threads") = 0, py::arg("write_threads") = 1,
+             py::arg("queue_size") = 256)
+        .def("run", &Stockfish::PipelineHandle::run,
+             "Evaluate positions through the pipeline, returning arrays like evaluate_batch",
+             py::arg("fens"), py::arg("activations") = false, py::arg("planes") = "")
+        .def("stats", &Stockfish::PipelineHandle::stats,
+             "Get the per-stage item counts, busy/starved/blocked times and throughput")
+        .def("reset_stats", &Stockfish::PipelineHandle::reset_stats,
+             "Reset the per-stage counters");
+    
+    py::class_<Stockfish::CoalescerHandle>(m, "Coalescer",
+          "Micro-batching coalescer of concurrent requests with a batch size and a latency deadline")
+        .def(py::init<size_t, size_t, std::uint64_t>(),
+             py::arg("threads") = 0, py::arg("max_batch") = 256, py::arg("max_delay_us") = 200)
+        .def("evaluate", &Stockfish::CoalescerHandle::evaluate,
+             "Evaluate positions in a shared batch, blocking the calling thread until done",
+             py::arg("fens"), py::arg("activations") = false)
+        .def("evaluate_async", &Stockfish::CoalescerHandle::evaluate_async,
+             "Evaluate positions in a shared batch, returning an asyncio future",
+             py::arg("fens"), py::arg("activations") = false)
+        .def("stats", &Stockfish::CoalescerHandle::stats,
+             "Get the latency, batch size and requests per batch histograms with their quantiles")
+        .def("reset_stats", &Stockfish::CoalescerHandle::reset_stats,
+             "Reset the histograms");
+    
+    py::class_<Stockfish::ServerHandle>(m, "Server",
+          "Evaluation server speaking a binary protocol on a Unix domain socket")
+        .def(py::init<const std::string&, size_t, size_t, std::uint64_t, size_t>(),
+             py::arg("path"), py::arg("threads") = 0, py::arg("max_batch") = 1024,
+             py::arg("max_delay_us") = 0, py::arg("max_in_flight") = 64)
+        .def("stop", &Stockfish::ServerHandle::stop,
+             "Stop accepting, answer the requests already read and close the connections")
+        .def("stats", &Stockfish::ServerHandle::stats,
+             "Get the open connections and the latency, batch size and requests per batch histograms")
+        .def("reset_stats", &Stockfish::ServerHandle::reset_stats,
+             "Reset the histograms");
+    
+    m.def("server_benchmark", &Stockfish::server_benchmark,
+          "Measure the throughput and round trip latency of a Server over loopback connections",
+          py::arg("path"), py::arg("fens"), py::arg("connections") = 4, py::arg("pipeline") = 8,
+          py::arg("positions") = 1, py::arg("requests") = 10000, py::arg("activations") = false);
+    
+    m.def("get_tablebase_residency", &Stockfish::get_tablebase_residency,
+          "Get the number of mapped tablebase files and how many of their bytes are in memory");
 }
\ No newline at end of file
@@ -32,6 +32,7 @@
 #include <sstream>
 #include <string_view>
 #include <sys/stat.h>
+#include <thread>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -443,6 +444,7 @@ class TBTables {
 
     std::deque<TBTable<WDL>> wdlTable;
     std::deque<TBTable<DTZ>> dtzTable;
+    std::vector<std::string> codes;  // Material code of each pair of tables, like "KRvK"
     size_t                   foundDTZFiles = 0;
     size_t                   foundWDLFiles = 0;
 
@@ -488,6 +490,7 @@ class TBTables {
         memset(hashTable, 0, sizeof(hashTable));
         wdlTable.clear();
         dtzTable.clear();
+        codes.clear();
         foundDTZFiles = 0;
         foundWDLFiles = 0;
     }
@@ -498,10 +501,55 @@ class TBTables {
     }
 
     void add(const std::vector<PieceType>& pieces);
+
+    // Calls fn(code, wdl, dtz) for each pair of tables found at init time
+    template<typename Fn>
+    void for_each(const Fn& fn) {
+        for (size_t i = 0; i < codes.size(); ++i)
+            fn(codes[i], wdlTable[i], dtzTable[i]);
+    }
 };
 
 TBTables TBTables;
 
+// TBWarmer runs Tablebases::warm() in the background. The thread walks the
+// TBTables storage, so it is joined before the tables are cleared and at exit.
+// The mutex lets callers wait for it from any thread.
+class TBWarmer {
+
+    std::thread      thread;
+    std::mutex       mutex;
+    std::atomic_bool busy{false};
+
+    void join() {
+        if (thread.joinable())
+            thread.join();
+    }
+
+   public:
+    template<typename Fn>
+    void start(Fn fn) {
+        std::lock_guard<std::mutex> lk(mutex);
+        join();
+        busy   = true;
+        thread = std::thread([this, fn]() {
+            fn();
+            busy = false;
+        });
+    }
+
+    void wait() {
+        std::lock_guard<std::mutex> lk(mutex);
+        join();
+    }
+
+    bool running() const { return busy; }
+
+    ~TBWarmer() { wait(); }
+};
+
+TBWarmer TBWarmer;
+
 // If the corresponding file exists two new objects TBTable<WDL> and TBTable<DTZ>
 // are created and added to the lists and hash table. Called at init time.
 void TBTables::add(const std::vector<PieceType>& pieces) {
@@ -531,6 +579,7 @@ void TBTables::add(const std::vector<PieceType>& pieces) {
 
     wdlTable.emplace_back(code);
     dtzTable.emplace_back(wdlTable.back());
+    codes.push_back(code);
 
     // Insert into the hash keys for both colors: KRvK with KR white and black
     insert(wdlTable.back().key, &wdlTable.back(), &dtzTable.back());
@@ -1332,6 +1381,76 @@ WDLScore search(Position& pos, ProbeState* result) {
     return *result = OK, value;
 }
 
+// The headers, sparse indices and block lengths of a table are stored in one
+// run at the start of the file, followed by the compressed data of the first
+// PairsData record.
+template<TBType Type>
+size_t index_size(TBTable<Type>& e) {
+    return size_t(e.get(0, FILE_A)->data - (uint8_t*) e.baseAddress);
+}
+
+size_t page_size() {
+#ifndef _WIN32
+    static const size_t size = size_t(sysconf(_SC_PAGESIZE));
+    return size;
+#else
+    return 4096;
+#endif
+}
+
+// Brings a region of a mapped file into memory. MADV_WILLNEED only queues the
+// reads, prefaulting touches every page and returns once they are resident.
+void warm_region(const uint8_t* begin, size_t size, bool prefault) {
+
+    const uintptr_t first = uintptr_t(begin) & ~uintptr_t(page_size() - 1);
+    const uintptr_t last  = uintptr_t(begin) + size;
+
+#if !defined(_WIN32) && defined(MADV_WILLNEED)
+    if (!prefault)
+    {
+        madvise((void*) first, last - first, MADV_WILLNEED);
+        return;
+    }
+#else
+    (void) prefault;
+#endif
+
+    for (uintptr_t p = first; p < last; p += page_size())
+        (void) *(const volatile uint8_t*) p;
+}
+
+// Number of bytes of a mapped file that are currently in memory
+size_t resident_bytes([[maybe_unused]] void* baseAddress, [[maybe_unused]] size_t size) {
+
+#ifndef _WIN32
+    #if defined(__APPLE__)
+    std::vector<char> pages((size + page_size() - 1) / page_size());
+    #else
+    std::vector<unsigned char> pages((size + page_size() - 1) / page_size());
+    #endif
+
+    if (mincore(baseAddress, size, pages.data()))
+        return 0;
+
+    size_t count = 0;
+    for (auto p : pages)
+        count += p & 1;
+
+    return std::min(size, count * page_size());
+#else
+    return 0;
+#endif
+}
+
+// True if a material code like "KRvK" (either side first) names the table
+bool matches(const std::string& code, const std::string& material) {
+
+    size_t v = material.find('v');
+
+    return material == code
+        || (v != std::string::npos && material.substr(v + 1) + 'v' + material.substr(0, v) == code);
+}
+
 }  // namespace
 
 
@@ -1340,6 +1459,7 @@ WDLScore search(Position& pos, ProbeState* result) {
 // safe, nor it needs to be.
 void Tablebases::init(const std::string& paths) {
 
+    TBWarmer.wait();
     TBTables.clear();
     MaxCardinality = 0;
     TBFile::Paths  = paths;
@@ -1487,6 +1607,61 @@ void Tablebases::init(const std::string& paths) {
     TBTables.info();
 }
 
+// Maps the WDL and DTZ tables of the given materials (all tables if empty) and
+// loads their index regions into memory on a background thread, so that the
+// first probes don't pay a major page fault for each lookup. The compressed
+// data itself is left to be paged in on demand.
+void Tablebases::warm(const std::vector<std::string>& materials, bool prefault) {
+
+    TBWarmer.start([materials, prefault]() {
+        TBTables.for_each([&](const std::string& code, TBTable<WDL>& wdl, TBTable<DTZ>& dtz) {
+            if (!materials.empty()
+                && std::none_of(materials.begin(), materials.end(),
+                                [&](const std::string& m) { return matches(code, m); }))
+                return;
+
+            StateInfo st;
+            Position  pos;
+            pos.set(code, WHITE, &st);
+
+            if (mapped(wdl, pos))
+                warm_region((uint8_t*) wdl.baseAddress, index_size(wdl), prefault);
+
+            if (mapped(dtz, pos))
+                warm_region((uint8_t*) dtz.baseAddress, index_size(dtz), prefault);
+        });
+    });
+}
+
+// Waits for a pending warm() to complete
+void Tablebases::wait_warm() { TBWarmer.wait(); }
+
+// Reports how much of the mapped tables is in memory
+Residency Tablebases::residency() {
+
+    Residency r;
+    r.warming = TBWarmer.running();
+
+    auto add = [&](auto& e) {
+        if (!e.ready.load(std::memory_order_acquire) || !e.baseAddress)
+            return;
+
+        r.tables++;
+        r.indexBytes += index_size(e);
+#ifndef _WIN32
+        r.mappedBytes += e.mapping;
+        r.residentBytes += resident_bytes(e.baseAddress, e.mapping);
+#endif
+    };
+
+    TBTables.for_each([&](const std::string&, TBTable<WDL>& wdl, TBTable<DTZ>& dtz) {
+        add(wdl);
+        add(dtz);
+    });
+
+    return r;
+}
+
 // Probe the WDL table for a particular position.
 // If *result != FAIL, the probe was successful.
 // The return value is from the point of view of the side to move:
@@ -19,6 +19,7 @@
 #ifndef TBPROBE_H
 #define TBPROBE_H
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -60,6 +61,15 @@ enum ProbeState {
     ZEROING_BEST_MOVE = 2    // Best move zeroes DTZ (capture or pawn move)
 };
 
+// Memory usage of the mapped tables, see residency()
+struct Residency {
+    size_t tables        = 0;  // Tables that have been mapped
+    size_t mappedBytes   = 0;  // Total size of their files (not available on Windows)
+    size_t indexBytes    = 0;  // Size of their headers and indices
+    size_t residentBytes = 0;  // Bytes currently in memory (not available on Windows)
+    bool   warming       = false;
+};
+
 extern int MaxCardinality;
 
 
@@ -73,6 +83,10 @@ Config   rank_root_moves(const OptionsMap&  options,
                          Search::RootMoves& rootMoves,
                          bool               rankDTZ = false);
 
+void      warm(const std::vector<std::string>& materials = {}, bool prefault = false);
+void      wait_warm();
+Residency residency();
+
 }  // namespace Stockfish::Tablebases
 
 #endif
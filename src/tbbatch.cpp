@@ -0,0 +1,211 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tbbatch.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "batch.h"
+#include "position.h"
+
+namespace Stockfish::Batch {
+
+ProbeCache::ProbeCache(std::size_t cap) :
+    capacity(std::max<std::size_t>(1, cap)) {
+    nodes.reserve(capacity);
+    index.reserve(capacity);
+}
+
+
+void ProbeCache::clear() {
+    nodes.clear();
+    index.clear();
+    head = tail = None;
+}
+
+
+void ProbeCache::unlink(std::uint32_t idx) {
+    Node& n = nodes[idx];
+    (n.prev != None ? nodes[n.prev].next : head) = n.next;
+    (n.next != None ? nodes[n.next].prev : tail) = n.prev;
+}
+
+
+void ProbeCache::push_front(std::uint32_t idx) {
+    Node& n = nodes[idx];
+    n.prev  = None;
+    n.next  = head;
+    (head != None ? nodes[head].prev : tail) = idx;
+    head                                     = idx;
+}
+
+
+// Returns the cached result and marks it as the most recently used one
+const TBResult* ProbeCache::find(Key materialKey, Key key) {
+
+    auto it = index.find(key);
+    if (it == index.end() || nodes[it->second].materialKey != materialKey)
+        return nullptr;
+
+    if (it->second != head)
+    {
+        unlink(it->second);
+        push_front(it->second);
+    }
+
+    ++hitCount;
+    return &nodes[it->second].result;
+}
+
+
+// Adds or updates the result, evicting the least recently used one when full
+void ProbeCache::insert(Key materialKey, Key key, const TBResult& result) {
+
+    std::uint32_t idx;
+    auto          it = index.find(key);
+
+    if (it != index.end())
+    {
+        idx = it->second;
+        unlink(idx);
+    }
+    else if (nodes.size() < capacity)
+    {
+        idx = std::uint32_t(nodes.size());
+        nodes.emplace_back();
+        index.emplace(key, idx);
+    }
+    else
+    {
+        idx = tail;
+        unlink(idx);
+        index.erase(nodes[idx].key);
+        index.emplace(key, idx);
+    }
+
+    nodes[idx].materialKey = materialKey;
+    nodes[idx].key         = key;
+    nodes[idx].result      = result;
+    push_front(idx);
+}
+
+
+Prober::Prober(std::size_t threads, std::size_t size) :
+    cacheSize(size) {
+    set_threads(threads);
+}
+
+
+void Prober::set_threads(std::size_t threads) { caches.resize(std::max<std::size_t>(1, threads)); }
+
+
+void Prober::clear() {
+    for (auto& c : caches)
+        if (c)
+            c->clear();
+}
+
+
+ProbeCache& Prober::cache(std::size_t threadIdx) {
+    auto& c = caches[threadIdx];
+    if (!c)
+        c = std::make_unique<ProbeCache>(cacheSize);
+    return *c;
+}
+
+
+// Tables don't cover positions with castling rights, and there is no table
+// for more pieces than MaxCardinality.
+bool Prober::in_tablebases(const Position& pos) {
+    return pos.count<ALL_PIECES>() <= Tablebases::MaxCardinality
+        && !pos.can_castle(ANY_CASTLING);
+}
+
+
+bool Prober::probe(std::size_t threadIdx, Position& pos, bool wantsDTZ, TBResult& result) {
+
+    if (!in_tablebases(pos))
+        return false;
+
+    ProbeCache& c = cache(threadIdx);
+
+    if (const TBResult* r = c.find(pos.material_key(), pos.key()); r && (r->hasDTZ || !wantsDTZ))
+    {
+        result = *r;
+        return true;
+    }
+
+    Tablebases::ProbeState state;
+
+    result          = TBResult();
+    result.wdl      = std::int8_t(Tablebases::probe_wdl(pos, &state));
+    result.wdlState = std::int8_t(state);
+
+    if (wantsDTZ)
+    {
+        result.dtz      = std::int16_t(Tablebases::probe_dtz(pos, &state));
+        result.dtzState = std::int8_t(state);
+        result.hasDTZ   = true;
+    }
+
+    c.insert(pos.material_key(), pos.key(), result);
+    return true;
+}
+
+
+TBStats Prober::probe(const std::vector<std::string>& input, const TBOutputs& out) {
+
+    const std::vector<std::string> fens = checked_fens(input);
+    const std::size_t              n    = fens.size();
+    TBStats                        stats;
+    stats.positions = n;
+
+    std::vector<std::size_t> hitsBefore(caches.size());
+    for (std::size_t t = 0; t < caches.size(); ++t)
+        hitsBefore[t] = caches[t] ? caches[t]->hits() : 0;
+
+    std::atomic<std::size_t> probed{0};
+
+    parallel_for(caches.size(), n, [&](std::size_t t, std::size_t i) {
+        StateInfo st;
+        Position  pos;
+        pos.set(fens[i], false, &st);
+
+        TBResult r;
+        if (probe(t, pos, out.dtz || out.dtzState, r))
+            probed.fetch_add(1, std::memory_order_relaxed);
+
+        if (out.wdl)
+            out.wdl[i] = r.wdl;
+        if (out.wdlState)
+            out.wdlState[i] = r.wdlState;
+        if (out.dtz)
+            out.dtz[i] = r.dtz;
+        if (out.dtzState)
+            out.dtzState[i] = r.dtzState;
+    });
+
+    stats.probed = probed;
+    for (std::size_t t = 0; t < caches.size(); ++t)
+        stats.hits += (caches[t] ? caches[t]->hits() : 0) - hitsBefore[t];
+
+    return stats;
+}
+
+}  // namespace Stockfish::Batch
@@ -0,0 +1,129 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TBBATCH_H_INCLUDED
+#define TBBATCH_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "syzygy/tbprobe.h"
+#include "types.h"
+
+namespace Stockfish {
+
+class Position;
+
+namespace Batch {
+
+// Outcome of probing one position. States hold a Tablebases::ProbeState, and
+// the DTZ fields are only meaningful if hasDTZ is set.
+struct TBResult {
+    std::int8_t  wdl      = Tablebases::WDLDraw;
+    std::int8_t  wdlState = Tablebases::FAIL;
+    std::int16_t dtz      = 0;
+    std::int8_t  dtzState = Tablebases::FAIL;
+    bool         hasDTZ   = false;
+};
+
+// ProbeCache is a small LRU of probe results, private to one thread, so that
+// repeated positions don't go through the move generation and the mapped table
+// decompression again. Entries are keyed by the material and position keys.
+class ProbeCache {
+   public:
+    explicit ProbeCache(std::size_t capacity);
+
+    const TBResult* find(Key materialKey, Key key);
+    void            insert(Key materialKey, Key key, const TBResult& result);
+    void            clear();
+
+    std::size_t hits() const { return hitCount; }
+
+   private:
+    static constexpr std::uint32_t None = ~std::uint32_t(0);
+
+    struct Node {
+        Key           materialKey;
+        Key           key;
+        TBResult      result;
+        std::uint32_t prev, next;
+    };
+
+    void unlink(std::uint32_t idx);
+    void push_front(std::uint32_t idx);
+
+    std::vector<Node>                       nodes;
+    std::unordered_map<Key, std::uint32_t> index;
+    std::size_t                             capacity;
+    std::uint32_t                           head = None, tail = None;
+    std::size_t                             hitCount = 0;
+};
+
+// Destination buffers of a batch probe, one row per input position. Null
+// pointers are skipped, and DTZ tables are only probed if dtz is set.
+struct TBOutputs {
+    std::int8_t*  wdl      = nullptr;  // [n] WDLScore, side to move point of view
+    std::int8_t*  wdlState = nullptr;  // [n] ProbeState of the WDL probe
+    std::int16_t* dtz      = nullptr;  // [n] see Tablebases::probe_dtz()
+    std::int8_t*  dtzState = nullptr;  // [n] ProbeState of the DTZ probe
+};
+
+struct TBStats {
+    std::size_t positions = 0;
+    std::size_t probed    = 0;  // Positions within the tablebase cardinality
+    std::size_t hits      = 0;  // Probes answered by the per-thread caches
+};
+
+// Probes the Syzygy tables for many independent positions on a set of worker
+// threads. The tables must have been loaded with Tablebases::init(), and the
+// caches must be cleared whenever that is called again.
+class Prober {
+   public:
+    static constexpr std::size_t DefaultCacheSize = 4096;
+
+    explicit Prober(std::size_t threads, std::size_t cacheSize = DefaultCacheSize);
+
+    void        set_threads(std::size_t threads);
+    std::size_t threads() const { return caches.size(); }
+    void        clear();
+
+    // Throws std::invalid_argument, probing nothing, if a FEN is not well formed
+    TBStats probe(const std::vector<std::string>& fens, const TBOutputs& out);
+
+    // Probes a single position with the cache of the given worker thread. Returns
+    // false, without probing, if the position can't be in the tablebases.
+    bool probe(std::size_t threadIdx, Position& pos, bool wantsDTZ, TBResult& result);
+
+    static bool in_tablebases(const Position& pos);
+
+   private:
+    ProbeCache& cache(std::size_t threadIdx);
+
+    std::size_t                              cacheSize;
+    std::vector<std::unique_ptr<ProbeCache>> caches;
+};
+
+}  // namespace Batch
+
+}  // namespace Stockfish
+
+#endif  // #ifndef TBBATCH_H_INCLUDED
@@ -139,7 +139,8 @@ uint64_t ThreadPool::tb_hits() const { return accumulate(&Search::Worker::tbHits
 // Upon resizing, threads are recreated to allow for binding if necessary.
 void ThreadPool::set(const NumaConfig&                           numaConfig,
                      Search::SharedState                         sharedState,
-                     const Search::SearchManager::UpdateContext& updateContext) {
+                     const Search::SearchManager::UpdateContext& updateContext,
+                     size_t                                      threadCount) {
 
     if (threads.size() > 0)  // destroy any existing thread(s)
     {
@@ -150,7 +151,7 @@ void ThreadPool::set(const NumaConfig&                           numaConfig,
         boundThreadToNumaNode.clear();
     }
 
-    const size_t requested = sharedState.options["Threads"];
+    const size_t requested = threadCount ? threadCount : size_t(sharedState.options["Threads"]);
 
     if (requested > 0)  // create new thread(s)
     {
@@ -137,7 +137,8 @@ class ThreadPool {
     void   clear();
     void   set(const NumaConfig& numaConfig,
                Search::SharedState,
-               const Search::SearchManager::UpdateContext&);
+               const Search::SearchManager::UpdateContext&,
+               size_t threadCount = 0);  // 0 for the Threads option
 
     Search::SearchManager* main_manager();
     Thread*                main_thread() const { return threads.front().get(); }
@@ -18,11 +18,24 @@
 
 #include "tt.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <climits>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <utility>
+
+#if !defined(_WIN32)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
 
 #include "memory.h"
 #include "misc.h"
@@ -149,11 +162,61 @@ struct Cluster {
 static_assert(sizeof(Cluster) == 32, "Suboptimal Cluster size");
 
 
+// Files written by TranspositionTable::save() start with this header, padded to
+// TTFileHeaderSize bytes so that the clusters after it are page aligned when the
+// file is mapped. The clusters follow in table order, in native byte order.
+struct TTFileHeader {
+    char     magic[8];
+    uint64_t clusterCount;
+    uint32_t clusterBytes;
+    uint8_t  generation8;
+    uint8_t  padding[3];
+    char     version[64];  // engine_version_info(), entries are only reused by the same engine
+};
+
+static constexpr size_t TTFileHeaderSize = 4096;
+static constexpr char   TTFileMagic[8]   = {'S', 'F', 'T', 'T', 'A', 'B', 'L', 'E'};
+
+static_assert(sizeof(TTFileHeader) <= TTFileHeaderSize, "TTFileHeader must fit its page");
+
+static TTFileHeader make_header(size_t clusterCount, uint8_t generation8) {
+    TTFileHeader header{};
+    std::memcpy(header.magic, TTFileMagic, sizeof(TTFileMagic));
+    header.clusterCount = clusterCount;
+    header.clusterBytes = sizeof(Cluster);
+    header.generation8  = generation8;
+    std::strncpy(header.version, engine_version_info().c_str(), sizeof(header.version) - 1);
+    return header;
+}
+
+
+// Clusters [first, last] of a table of `to` clusters where the keys of clusters
+// [begin, end) of a table of `from` clusters hash to, see first_entry()
+static std::pair<size_t, size_t> scaled_range(size_t begin, size_t end, size_t from, size_t to) {
+#if defined(__GNUC__) && defined(IS_64BIT)
+    __extension__ using uint128 = unsigned __int128;
+    return {size_t(uint128(begin) * to / from), size_t((uint128(end) * to - 1) / from)};
+#else
+    using ld = long double;
+    return {size_t(ld(begin) * to / from), size_t((ld(end) * to - 1) / from)};
+#endif
+}
+
+
+#if !defined(_WIN32)
+// Canonical path of an existing file, to recognize the file a table is mapped from
+static std::string canonical_path(const std::string& path) {
+    char resolved[PATH_MAX];
+    return realpath(path.c_str(), resolved) ? std::string(resolved) : std::string();
+}
+#endif
+
+
 // Sets the size of the transposition table,
 // measured in megabytes. Transposition table consists
 // of clusters and each cluster consists of ClusterSize number of TTEntry.
 void TranspositionTable::resize(size_t mbSize, ThreadPool& threads) {
-    aligned_large_pages_free(table);
+    release();
 
     clusterCount = mbSize * 1024 * 1024 / sizeof(Cluster);
 
@@ -169,6 +232,102 @@ void TranspositionTable::resize(size_t mbSize, ThreadPool& threads) {
 }
 
 
+// Sets the size of the transposition table like resize(), but moves its entries
+// into the new table. Only the low 16 bits of a key are kept in the table, so when
+// the table grows an entry is known to belong to one of the new clusters its old
+// cluster's keys spread to, not which one. Copies keep the depth and generation of
+// their entry, so a copy in a cluster the position does not hash to competes with
+// fresh entries as a real one would. The entry is thus copied to every candidate
+// cluster only if there are at most MaxCopies of them, and otherwise to one of
+// them picked by its key bits, where it is found with a probability of one in
+// the number of candidates.
+void TranspositionTable::rehash(size_t mbSize, ThreadPool& threads) {
+    constexpr size_t MaxCopies = 2;
+
+    if (!table)
+        return resize(mbSize, threads);
+
+    const size_t oldCount = clusterCount;
+    const size_t newCount = mbSize * 1024 * 1024 / sizeof(Cluster);
+
+    Cluster* newTable = static_cast<Cluster*>(aligned_large_pages_alloc(newCount * sizeof(Cluster)));
+
+    if (!newTable)
+    {
+        std::cerr << "Failed to allocate " << mbSize << "MB for transposition table." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    // Empty slots rank below every entry, the others are valued as in probe()
+    const auto rank = [this](const TTEntry& e) {
+        return e.is_occupied() ? e.depth8 - e.relative_age(generation8) : INT_MIN;
+    };
+
+    // Replaces the entry of the same position if any, else the lowest ranked one
+    const auto insert = [&](Cluster& cluster, const TTEntry& e) {
+        TTEntry* replace = &cluster.entry[0];
+        for (TTEntry& slot : cluster.entry)
+            if (slot.is_occupied() && slot.key16 == e.key16)
+            {
+                replace = &slot;
+                break;
+            }
+            else if (rank(slot) < rank(*replace))
+                replace = &slot;
+
+        if (rank(e) > rank(*replace))
+            *replace = e;
+    };
+
+    const size_t threadCount = threads.num_threads();
+
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        threads.run_on_thread(i, [&, i]() {
+            // Each thread owns a part of the new table, so no cluster is written concurrently
+            const size_t stride = newCount / threadCount;
+            const size_t start  = stride * i;
+            const size_t len    = i + 1 != threadCount ? stride : newCount - start;
+
+            std::memset(&newTable[start], 0, len * sizeof(Cluster));
+
+            if (!len)
+                return;
+
+            const auto [first, last] = scaled_range(start, start + len, newCount, oldCount);
+
+            for (size_t idx = first; idx <= last && idx < oldCount; ++idx)
+            {
+                const auto [lo, hi] = scaled_range(idx, idx + 1, oldCount, newCount);
+                const size_t copies = hi - lo + 1;
+
+                for (const TTEntry& e : table[idx].entry)
+                {
+                    if (!e.is_occupied())
+                        continue;
+
+                    const size_t from = copies <= MaxCopies ? lo : lo + e.key16 % copies;
+                    const size_t to   = copies <= MaxCopies ? hi : from;
+
+                    for (size_t j = std::max(from, start); j <= std::min(to, start + len - 1); ++j)
+                        insert(newTable[j], e);
+                }
+            }
+        });
+    }
+
+    for (size_t i = 0; i < threadCount; ++i)
+        threads.wait_on_thread(i);
+
+    const uint8_t generation = generation8;
+    release();
+
+    table        = newTable;
+    clusterCount = newCount;
+    generation8  = generation;
+}
+
+
 // Initializes the entire transposition table to zero,
 // in a multi-threaded way.
 void TranspositionTable::clear(ThreadPool& threads) {
@@ -192,6 +351,134 @@ void TranspositionTable::clear(ThreadPool& threads) {
 }
 
 
+// Frees the table, or unmaps it after recording the current
+// generation in the header of the file it was loaded from.
+void TranspositionTable::release() {
+#if !defined(_WIN32)
+    if (mapping)
+    {
+        static_cast<TTFileHeader*>(mapping)->generation8 = generation8;
+        munmap(mapping, mappingSize);
+
+        mapping     = nullptr;
+        mappingSize = 0;
+        table       = nullptr;
+        mappedPath.clear();
+        return;
+    }
+#endif
+
+    aligned_large_pages_free(table);
+    table = nullptr;
+}
+
+
+bool TranspositionTable::save(const std::string& path, std::string& error) const {
+    const TTFileHeader header = make_header(clusterCount, generation8);
+
+#if !defined(_WIN32)
+    // Rewriting the file the table is mapped from would truncate it under the
+    // mapping; its clusters are already there, so only the header and the
+    // dirty pages have to be written back.
+    if (mapping && canonical_path(path) == mappedPath)
+    {
+        std::memcpy(mapping, &header, sizeof(header));
+        if (msync(mapping, mappingSize, MS_SYNC) != 0)
+        {
+            error = path + ": " + std::strerror(errno);
+            return false;
+        }
+        return true;
+    }
+#endif
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    const char    zeros[TTFileHeaderSize] = {};
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(zeros, TTFileHeaderSize - sizeof(header));
+
+    // Write in chunks, as a single write of a multi-gigabyte table may fail on some systems
+    constexpr size_t Chunk = size_t(1) << 26;
+    const char*      data  = reinterpret_cast<const char*>(table);
+
+    for (size_t done = 0, total = clusterCount * sizeof(Cluster); file && done < total; done += Chunk)
+        file.write(data + done, std::streamsize(std::min(Chunk, total - done)));
+
+    if (!file.flush())
+    {
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+
+bool TranspositionTable::load(const std::string& path, std::string& error) {
+#if defined(_WIN32)
+    error = "loading a transposition table is not supported on this platform";
+    return false;
+#else
+    const int fd = open(path.c_str(), O_RDWR);
+    if (fd < 0)
+    {
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    // The header is checked before mapping: the file must hold exactly the clusters
+    // it declares, and at least the 1000 that hashfull() samples
+    struct stat  st;
+    TTFileHeader header;
+    std::string  problem;
+
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < TTFileHeaderSize
+        || pread(fd, &header, sizeof(header), 0) != ssize_t(sizeof(header)))
+        problem = path + " is not a transposition table file";
+
+    else if (std::memcmp(header.magic, TTFileMagic, sizeof(TTFileMagic)) != 0
+             || header.clusterBytes != sizeof(Cluster) || header.clusterCount < 1000
+             || (size_t(st.st_size) - TTFileHeaderSize) % sizeof(Cluster) != 0
+             || header.clusterCount != (size_t(st.st_size) - TTFileHeaderSize) / sizeof(Cluster))
+        problem = path + " is not a transposition table file";
+
+    else if (std::strncmp(header.version, make_header(0, 0).version, sizeof(header.version)) != 0)
+        problem = path + " was written by "
+                + std::string(header.version, strnlen(header.version, sizeof(header.version)));
+
+    if (!problem.empty())
+    {
+        close(fd);
+        error = problem;
+        return false;
+    }
+
+    const size_t size = size_t(st.st_size);
+    void*        base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);  // The mapping keeps the file open
+
+    if (base == MAP_FAILED)
+    {
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    // Start reading the file in ahead of the first probes, without waiting for it
+    madvise(base, size, MADV_WILLNEED);
+
+    release();
+
+    mapping      = base;
+    mappingSize  = size;
+    mappedPath   = canonical_path(path);
+    clusterCount = header.clusterCount;
+    generation8  = header.generation8;
+    table        = reinterpret_cast<Cluster*>(static_cast<char*>(base) + TTFileHeaderSize);
+    return true;
+#endif
+}
+
+
 // Returns an approximation of the hashtable
 // occupation during a search. The hash is x permill full, as per UCI protocol.
 // Only counts entries which match the current generation.
@@ -207,12 +494,44 @@ int TranspositionTable::hashfull(int maxAge) const {
 }
 
 
+// With several engines attached, entries would age as many times faster as there are
+// engines if each of their searches advanced the generation, and the entries of an
+// engine would look stale to the others in the middle of its search. So the
+// generation advances when as many searches as there are engines have started since
+// it last did: as often as for a single engine when the engines search in turn.
 void TranspositionTable::new_search() {
-    // increment by delta to keep lower bits as is
-    generation8 += GENERATION_DELTA;
+    std::lock_guard<std::mutex> lk(generationMutex);
+
+    if (++searchesStarted >= users)
+    {
+        searchesStarted = 0;
+        // increment by delta to keep lower bits as is
+        generation8 += GENERATION_DELTA;
+    }
+}
+
+
+void TranspositionTable::attach() {
+    std::lock_guard<std::mutex> lk(generationMutex);
+    ++users;
+}
+
+
+void TranspositionTable::detach() {
+    std::lock_guard<std::mutex> lk(generationMutex);
+    --users;
+}
+
+
+int TranspositionTable::attached() const {
+    std::lock_guard<std::mutex> lk(generationMutex);
+    return users;
 }
 
 
+size_t TranspositionTable::size_mb() const { return clusterCount * sizeof(Cluster) / (1024 * 1024); }
+
+
 uint8_t TranspositionTable::generation() const { return generation8; }
 
 
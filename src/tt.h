@@ -19,8 +19,11 @@
 #ifndef TT_H_INCLUDED
 #define TT_H_INCLUDED
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <mutex>
+#include <string>
 #include <tuple>
 
 #include "memory.h"
@@ -81,9 +84,12 @@ struct TTWriter {
 class TranspositionTable {
 
    public:
-    ~TranspositionTable() { aligned_large_pages_free(table); }
+    ~TranspositionTable() { release(); }
 
     void resize(size_t mbSize, ThreadPool& threads);  // Set TT size
+    // Set TT size keeping the entries: each thread fills its part of the new table with the entries
+    // of the old clusters whose keys hash there, keeping the most valuable ones (as in probe()).
+    void rehash(size_t mbSize, ThreadPool& threads);
     void clear(ThreadPool& threads);                  // Re-initialize memory, multithreaded
     int  hashfull(int maxAge = 0)
       const;  // Approximate what fraction of entries (permille) have been written to during this root search
@@ -95,14 +101,45 @@ class TranspositionTable {
     probe(const Key key) const;  // The main method, whose retvals separate local vs global objects
     TTEntry* first_entry(const Key key)
       const;  // This is the hash function; its only external use is memory prefetching.
+    size_t size_mb() const;
+
+    // Several engines may search with the same table, each attached while it uses it. Probes and
+    // writes need no more care than between threads of one engine, but the generation then only
+    // advances once every attached engine could have started a search, see new_search(). Resizing
+    // or clearing the table must wait for the searches of all of them, so engines refuse to
+    // resize or load a table that others are attached to, and don't clear it.
+    void attach();
+    void detach();
+    int  attached() const;
+
+    // Writes the table and its generation to a file, after a header recording its size and the
+    // engine version. Returns false and sets error on failure.
+    bool save(const std::string& path, std::string& error) const;
+
+    // Maps a file written by save() read-write in place of the table, so that loading costs no
+    // more than paging the clusters in as they are probed. Later writes go to the file, which
+    // keeps the generation when the table is released. The file must come from the same engine
+    // version. Returns false and sets error on failure, leaving the table unchanged. Clearing a
+    // mapped table would zero the file, so engines don't clear it.
+    bool load(const std::string& path, std::string& error);
+    bool mapped() const { return mapping != nullptr; }
 
    private:
     friend struct TTEntry;
 
-    size_t   clusterCount;
+    void release();  // Free or unmap the table
+
+    size_t   clusterCount = 0;
     Cluster* table = nullptr;
 
-    uint8_t generation8 = 0;  // Size must be not bigger than TTEntry::genBound8
+    void*       mapping     = nullptr;  // Of the file the table was loaded from, if any
+    size_t      mappingSize = 0;
+    std::string mappedPath;
+
+    std::atomic<uint8_t> generation8{0};  // Size must be not bigger than TTEntry::genBound8
+
+    mutable std::mutex generationMutex;
+    int        users = 0, searchesStarted = 0;  // Attached engines, searches since the last new generation
 };
 
 }  // namespace Stockfish
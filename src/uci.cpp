@@ -22,6 +22,7 @@
 #include <cctype>
 #include <cmath>
 #include <cstdint>
+#include <fstream>
 #include <iterator>
 #include <optional>
 #include <sstream>
@@ -36,6 +37,7 @@
 #include "position.h"
 #include "score.h"
 #include "search.h"
+#include "server.h"
 #include "types.h"
 #include "ucioption.h"
 
@@ -148,6 +150,8 @@ void UCIEngine::loop() {
             sync_cout << engine.visualize() << sync_endl;
         else if (token == "eval")
             engine.trace_eval();
+        else if (token == "evalbatch")
+            evalbatch(is);
         else if (token == "compiler")
             sync_cout << compiler_info() << sync_endl;
         else if (token == "export_net")
@@ -162,6 +166,17 @@ void UCIEngine::loop() {
 
             engine.save_network(files);
         }
+        else if (token == "savehash" || token == "loadhash")
+        {
+            std::string path, error;
+            std::getline(is >> std::ws, path);
+
+            if (token == "savehash" ? engine.save_tt(path, error) : engine.load_tt(path, error))
+                print_info_string((token == "savehash" ? "Saved hash to " : "Loaded hash from ")
+                                  + path);
+            else
+                print_info_string("Failed: " + error);
+        }
         else if (token == "--help" || token == "help" || token == "--license" || token == "license")
             sync_cout
               << "\nStockfish is a powerful chess engine for playing and analyzing."
@@ -471,6 +486,104 @@ std::uint64_t UCIEngine::perft(const Search::LimitsType& limits) {
     return nodes;
 }
 
+// Static evaluation of many positions, for tools driving the engine. Reads
+// either <count> FEN lines from the input, or the FEN or EPD lines of a file:
+//
+//   evalbatch [binary] <count>
+//   evalbatch [binary] file <path>
+//
+// and answers with a line "evalbatch <n>", then one line per position with
+// the final, PSQT and positional scores in pawns and the network used
+// ("big" or "small"), or with binary, n records in the layout of the
+// evaluation server's Protocol::EvalRecord. Nothing is evaluated if a
+// position is not well formed.
+void UCIEngine::evalbatch(std::istream& is) {
+    std::string              token, line, error;
+    std::vector<std::string> fens;
+    bool                     binary = false;
+
+    auto add = [&](const std::string& text, std::size_t lineNumber) {
+        std::string fen = epd_to_fen(text);
+        if (fen.empty() && error.empty())
+            error = "invalid position on line " + std::to_string(lineNumber);
+        fens.push_back(fen);
+    };
+
+    while (is >> token)
+        if (token == "binary")
+            binary = true;
+
+        else if (token == "file")
+        {
+            std::getline(is >> std::ws, line);
+            std::ifstream file(line);
+
+            if (!file)
+            {
+                error = "cannot open " + line;
+                break;
+            }
+
+            for (std::size_t n = 1; std::getline(file, line); ++n)
+                if (!is_whitespace(line) && line[0] != '#')
+                    add(line, n);
+            break;
+        }
+
+        else
+        {
+            std::size_t count = 0;
+            if (!(std::istringstream(token) >> count))
+            {
+                error = "expected a count or a file, got " + token;
+                break;
+            }
+
+            for (std::size_t n = 1; fens.size() < count && std::getline(std::cin, line); ++n)
+                if (!is_whitespace(line))
+                    add(line, n);
+            break;
+        }
+
+    if (!error.empty())
+    {
+        print_info_string("evalbatch: " + error);
+        fens.clear();
+    }
+
+    const std::size_t  n = fens.size();
+    std::vector<float> final(n), psqt(n), positional(n);
+    std::vector<std::uint8_t> smallNet(n);
+
+    if (n)
+    {
+        Batch::Outputs out;
+        out.final      = final.data();
+        out.psqt       = psqt.data();
+        out.positional = positional.data();
+        out.smallNet   = smallNet.data();
+        engine.evaluate_batch(fens, out);
+    }
+
+    std::ostringstream ss;
+    ss << "evalbatch " << n << "\n";
+
+    if (binary)
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            Batch::Protocol::EvalRecord r{final[i], psqt[i], positional[i], smallNet[i], {}};
+            ss.write(reinterpret_cast<const char*>(&r), sizeof(r));
+        }
+    else
+        for (std::size_t i = 0; i < n; ++i)
+            ss << final[i] << ' ' << psqt[i] << ' ' << positional[i] << ' '
+               << (smallNet[i] ? "small" : "big") << '\n';
+
+    sync_cout_start();
+    std::cout << ss.str() << std::flush;
+    sync_cout_end();
+}
+
 void UCIEngine::position(std::istringstream& is) {
     std::string token, fen;
 
@@ -64,6 +64,7 @@ class UCIEngine {
     void          bench(std::istream& args);
     void          benchmark(std::istream& args);
     void          position(std::istringstream& is);
+    void          evalbatch(std::istream& is);
     void          setoption(std::istringstream& is);
     std::uint64_t perft(const Search::LimitsType&);
 
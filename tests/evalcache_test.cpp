@@ -0,0 +1,124 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Concurrent probe/save test of the EvalCache. Writers store entries and
+// activation blobs derived from their keys into a small cache, so that entries
+// and slots are overwritten all the time, while readers check that every hit
+// returns the data and the blob of the key it was asked for. A torn entry or
+// slot returned as a hit fails the test.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "evalcache.h"
+
+using namespace Stockfish;
+
+namespace {
+
+constexpr std::size_t BlobSize = 512;
+constexpr std::size_t Keys     = 1 << 16;
+
+Key key_of(std::uint64_t i) { return (i + 1) * 0x9E3779B97F4A7C15ULL; }
+
+EvalCacheData data_of(Key key) {
+    return {Value(std::int16_t(key >> 8)), Value(std::int16_t(key >> 24)),
+            Value(std::int16_t(key >> 40)), bool(key & 1)};
+}
+
+void fill_blob(Key key, std::uint64_t* blob) {
+    for (std::size_t i = 0; i < BlobSize / 8; ++i)
+        blob[i] = key ^ (i * 0xBF58476D1CE4E5B9ULL);
+}
+
+bool same(const EvalCacheData& a, const EvalCacheData& b) {
+    return a.final == b.final && a.psqt == b.psqt && a.positional == b.positional
+        && a.smallNet == b.smallNet;
+}
+
+// xorshift, one per thread
+std::uint64_t next(std::uint64_t& s) {
+    s ^= s << 13;
+    s ^= s >> 7;
+    s ^= s << 17;
+    return s;
+}
+
+}
+
+int main() {
+
+    EvalCache cache;
+    cache.resize(1, 64, BlobSize);  // Few clusters and slots for many keys
+
+    const unsigned threads = std::max(4u, std::thread::hardware_concurrency());
+    const auto     end     = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+
+    std::atomic<std::uint64_t> hits{0}, blobHits{0}, errors{0};
+    std::vector<std::thread>   workers;
+
+    for (unsigned t = 0; t < threads; ++t)
+        workers.emplace_back([&, t] {
+            std::uint64_t seed = 0x2545F4914F6CDD1DULL * (t + 1);
+            std::uint64_t blob[BlobSize / 8], expected[BlobSize / 8];
+
+            while (std::chrono::steady_clock::now() < end)
+                for (int n = 0; n < 1000; ++n)
+                {
+                    const Key key = key_of(next(seed) % Keys);
+
+                    if (t % 2)
+                    {
+                        fill_blob(key, blob);
+                        cache.save(key, data_of(key), next(seed) % 2 ? blob : nullptr);
+                        continue;
+                    }
+
+                    const bool    withBlob = next(seed) % 2;
+                    EvalCacheData data;
+
+                    if (!cache.probe(key, data, withBlob ? blob : nullptr))
+                        continue;
+
+                    ++hits;
+                    errors += !same(data, data_of(key));
+
+                    if (withBlob)
+                    {
+                        ++blobHits;
+                        fill_blob(key, expected);
+                        for (std::size_t i = 0; i < BlobSize / 8; ++i)
+                            errors += blob[i] != expected[i];
+                    }
+                }
+        });
+
+    for (auto& w : workers)
+        w.join();
+
+    std::printf("%u threads: %llu hits, %llu with activations, %llu errors\n", threads,
+                (unsigned long long) hits, (unsigned long long) blobHits,
+                (unsigned long long) errors);
+
+    return errors || !hits || !blobHits ? 1 : 0;
+}
@@ -0,0 +1,112 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Network reload test of the C API. A position is evaluated with the default
+// networks and the evaluation cache enabled, then again after loading a big
+// network whose output bias was changed. The second score must come from the
+// new network, not from the cache, and reloading the default networks must
+// give back the first score.
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "evaluate.h"
+#include "nnue_interface.h"
+
+namespace {
+
+const char* StartFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// The file ends with the output layer of the last layer stack, which the 32
+// pieces of the start position select: an int32 bias, then 32 int8 weights.
+bool write_shifted_network(const std::string& from, const std::string& to) {
+
+    std::ifstream             in(from, std::ios::binary);
+    std::vector<std::uint8_t> net((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    if (net.size() < 36)
+        return false;
+
+    std::uint8_t* bias  = &net[net.size() - 36];
+    std::uint32_t value = bias[0] | bias[1] << 8 | bias[2] << 16 | std::uint32_t(bias[3]) << 24;
+
+    value += 16 * 200;  // 16 output units per internal unit
+    for (int i = 0; i < 4; ++i)
+        bias[i] = std::uint8_t(value >> (8 * i));
+
+    std::ofstream out(to, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(net.data()), std::streamsize(net.size()));
+    return bool(out);
+}
+
+bool evaluate(nnue_context* ctx, float& eval) {
+
+    nnue_outputs out = {};
+    out.eval         = &eval;
+
+    if (nnue_evaluate_batch(ctx, &StartFEN, 1, 0, &out) == NNUE_OK)
+        return true;
+
+    std::printf("evaluation failed: %s\n", nnue_last_error(ctx));
+    return false;
+}
+
+}
+
+int main() {
+
+    const std::string dir     = NNUE_NET_DIR "/";
+    const std::string big     = dir + EvalFileDefaultNameBig;
+    const std::string small   = dir + EvalFileDefaultNameSmall;
+    const std::string shifted = "nnue_interface_test.nnue";
+
+    if (!write_shifted_network(big, shifted))
+    {
+        std::printf("cannot write %s from %s\n", shifted.c_str(), big.c_str());
+        return 1;
+    }
+
+    nnue_context* ctx = nnue_create(1);
+    nnue_set_eval_cache(ctx, 16);
+
+    float      before = 0, cached = 0, after = 0, restored = 0;
+    nnue_stats stats;
+
+    const bool ok = nnue_load_networks(ctx, big.c_str(), small.c_str()) == NNUE_OK
+                 && evaluate(ctx, before) && evaluate(ctx, cached)
+                 && nnue_get_stats(ctx, &stats) == NNUE_OK
+                 && nnue_load_networks(ctx, shifted.c_str(), small.c_str()) == NNUE_OK
+                 && evaluate(ctx, after)
+                 && nnue_load_networks(ctx, big.c_str(), small.c_str()) == NNUE_OK
+                 && evaluate(ctx, restored);
+
+    if (!ok)
+        std::printf("failed: %s\n", nnue_last_error(ctx));
+
+    std::printf("start position: %.2f, cached %.2f (%llu hits), shifted network %.2f, restored %.2f\n",
+                before, cached, (unsigned long long) stats.cache_hits, after, restored);
+
+    nnue_destroy(ctx);
+    std::remove(shifted.c_str());
+
+    return ok && stats.cache_hits && cached == before && after != before && restored == before ? 0 : 1;
+}